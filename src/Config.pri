@@ -34,6 +34,9 @@ CONFIG -= debug_and_release debug_and_release_target
 # Controls if we want to define our own regex engine using QRegularExpression
 DEFINES += SCI_OWNREGEX
 
+# Use PCRE2 directly on the UTF-8 document instead of QRegularExpression, e.g. "qmake CONFIG+=pcre2"
+pcre2: DEFINES += NN_REGEX_PCRE2
+
 DEFINES += ADS_STATIC
 
 msvc:QMAKE_CXXFLAGS += /guard:cf
@@ -178,17 +178,20 @@ void DockedEditor::addEditor(ScintillaNext *editor)
     }
 
     // Set the icon
-    if (editor->readOnly()) {
-        dockWidget->tabWidget()->setIcon(QIcon(":/icons/readonly.png"));
-    }
-    else {
-        dockWidget->tabWidget()->setIcon(QIcon(editor->canSaveToDisk() ? ":/icons/unsaved.png" : ":/icons/saved.png"));
-        connect(editor, &ScintillaNext::savePointChanged, dockWidget, [=](bool dirty) {
+    auto updateIcon = [=]() {
+        if (editor->readOnly()) {
+            dockWidget->tabWidget()->setIcon(QIcon(":/icons/readonly.png"));
+        }
+        else {
             const bool actuallyDirty = editor->canSaveToDisk();
             const QString iconPath = actuallyDirty ? ":/icons/unsaved.png" : ":/icons/saved.png";
             dockWidget->tabWidget()->setIcon(QIcon(iconPath));
-        });
-    }
+        }
+    };
+
+    updateIcon();
+    connect(editor, &ScintillaNext::savePointChanged, dockWidget, updateIcon);
+    connect(editor, &ScintillaNext::loadFinished, dockWidget, updateIcon);
 
     connect(editor, &ScintillaNext::closed, dockWidget, &ads::CDockWidget::closeDockWidget);
     connect(editor, &ScintillaNext::closed, this, [=]() { emit editorClosed(editor); });
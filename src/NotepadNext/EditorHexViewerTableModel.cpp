@@ -21,9 +21,9 @@
 #include "ScintillaNext.h"
 
 
-static int IndexToPos(const QModelIndex &index)
+static Sci_Position IndexToPos(const QModelIndex &index)
 {
-    return index.row() * 16 + index.column();
+    return static_cast<Sci_Position>(index.row()) * 16 + index.column();
 }
 
 EditorHexViewerTableModel::EditorHexViewerTableModel(QObject *parent)
@@ -45,7 +45,7 @@ QVariant EditorHexViewerTableModel::headerData(int section, Qt::Orientation orie
             return QString("%1").arg(section, 2, 16, QChar('0')).toUpper();
         }
         else if (orientation == Qt::Vertical) {
-            return QString("%1").arg(section * 16, 8, 16, QChar('0')).toUpper();
+            return QString("%1").arg(static_cast<qlonglong>(section) * 16, 8, 16, QChar('0')).toUpper();
         }
     }
     else if (role == Qt::TextAlignmentRole) {
@@ -60,7 +60,8 @@ int EditorHexViewerTableModel::rowCount(const QModelIndex &parent) const
     if (parent.isValid())
         return 0;
 
-    return (editor->length() / 16) + 1;
+    // Rows are limited to an int, which is still enough for documents up to 32 GB
+    return static_cast<int>(qMin<Sci_Position>((editor->length() / 16) + 1, INT_MAX));
 }
 
 int EditorHexViewerTableModel::columnCount(const QModelIndex &parent) const
@@ -81,7 +82,7 @@ QVariant EditorHexViewerTableModel::data(const QModelIndex &index, int role) con
             QString str;
 
             for (int i = 0; i < 16 ; ++i) {
-                int docPos = index.row() * 16 + i;
+                Sci_Position docPos = static_cast<Sci_Position>(index.row()) * 16 + i;
                 if (docPos >= editor->length()) break;
 
                 QChar c = QChar(static_cast<uchar>(editor->charAt(docPos)));
@@ -91,7 +92,7 @@ QVariant EditorHexViewerTableModel::data(const QModelIndex &index, int role) con
             return str;
         }
 
-        int docPos = IndexToPos(index);
+        Sci_Position docPos = IndexToPos(index);
         if (docPos >= editor->length()) return QVariant();
 
         unsigned char ch = static_cast<unsigned char>(editor->charAt(docPos));
@@ -113,7 +114,7 @@ bool EditorHexViewerTableModel::setData(const QModelIndex &index, const QVariant
 
         if (ok && charValue <= 255) {
             QByteArray byte(1, static_cast<char>(charValue));
-            int pos = IndexToPos(index);
+            Sci_Position pos = IndexToPos(index);
 
             editor->setTargetRange(pos, pos + 1);
             editor->replaceTarget(1, byte.constData());
@@ -19,8 +19,15 @@
 #include <QApplication>
 
 #include "EditorManager.h"
+#include "LargeFileProfile.h"
+#include "NotepadNextApplication.h"
+#include "PagedFileView.h"
 #include "ScintillaNext.h"
 #include "Scintilla.h"
+#include "Settings.h"
+
+#include <QThread>
+#include <QThreadPool>
 
 // Editor decorators
 #include "BraceMatch.h"
@@ -39,6 +46,9 @@ const int MARK_HIDELINESBEGIN = 23;
 const int MARK_HIDELINESEND = 22;
 const int MARK_HIDELINESUNDERLINE = 21;
 
+// Anything bigger can't be addressed with 32-bit positions
+const qint64 LARGE_TEXT_SIZE = 0x7FFFFFFF;
+
 
 static int DefaultFontSize()
 {
@@ -49,8 +59,14 @@ static int DefaultFontSize()
 }
 
 
-EditorManager::EditorManager(QObject *parent) : QObject(parent)
+EditorManager::EditorManager(NotepadNextApplication *app) :
+    QObject(app),
+    app(app),
+    settings(app->getSettings())
 {
+    // Leave a thread free for anything the user does in the meantime
+    prefetchPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+
     connect(this, &EditorManager::editorCreated, this, [=](ScintillaNext *editor) {
         connect(editor, &ScintillaNext::closed, this, [=]() {
             emit editorClosed(editor);
@@ -69,7 +85,7 @@ ScintillaNext *EditorManager::createEditor(const QString &name)
 
 ScintillaNext *EditorManager::createEditorFromFile(const QString &filePath, bool tryToCreate)
 {
-    ScintillaNext *editor = ScintillaNext::fromFile(filePath, tryToCreate);
+    ScintillaNext *editor = openFile(filePath, tryToCreate);
 
     if (editor) {
         manageEditor(editor);
@@ -103,6 +119,89 @@ void EditorManager::manageEditor(ScintillaNext *editor)
     emit editorCreated(editor);
 }
 
+bool EditorManager::isLargeFile(qint64 size, qint64 longestLine) const
+{
+    // A threshold of 0 turns that check off
+    const qint64 sizeThreshold = static_cast<qint64>(settings->largeFileSize()) * 1024 * 1024;
+    const qint64 lineLengthThreshold = settings->largeFileLineLength();
+
+    return (sizeThreshold > 0 && size >= sizeThreshold) || (lineLengthThreshold > 0 && longestLine >= lineLengthThreshold);
+}
+
+int EditorManager::documentOptionsForFile(const QString &filePath) const
+{
+    const QFileInfo fileInfo(filePath);
+    const qint64 size = fileInfo.size();
+    int documentOptions = SC_DOCUMENTOPTION_DEFAULT;
+
+    // Skipping the style bytes halves the memory needed for the document. If a plain text file turns
+    // out to need a lexer the styles get added back when the language is set.
+    if (isLargeFile(size) || app->detectLanguageFromExtension(fileInfo.suffix()) == QStringLiteral("Text")) {
+        documentOptions |= SC_DOCUMENTOPTION_STYLES_NONE;
+    }
+
+    if (size > LARGE_TEXT_SIZE) {
+        documentOptions |= SC_DOCUMENTOPTION_TEXT_LARGE;
+    }
+
+    return documentOptions;
+}
+
+bool EditorManager::isPagedFile(qint64 size) const
+{
+    const qint64 sizeThreshold = static_cast<qint64>(settings->pagedFileSize()) * 1024 * 1024;
+
+    return sizeThreshold > 0 && size >= sizeThreshold;
+}
+
+ScintillaNext *EditorManager::openFile(const QString &filePath, bool tryToCreate) const
+{
+    const QFileInfo fileInfo(filePath);
+
+    if (fileInfo.isFile() && isPagedFile(fileInfo.size())) {
+        return PagedFileView::openFile(filePath);
+    }
+
+    return ScintillaNext::fromFile(filePath, tryToCreate, documentOptionsForFile(filePath));
+}
+
+ScintillaNext *EditorManager::openFileDeferred(const QString &filePath) const
+{
+    const QFileInfo fileInfo(filePath);
+
+    // Paged files only ever read what is on screen, so there is nothing to gain by waiting
+    if (!fileInfo.isFile() || isPagedFile(fileInfo.size())) {
+        return openFile(filePath);
+    }
+
+    ScintillaNext *editor = new ScintillaNext(fileInfo.fileName());
+
+    editor->setFileInfo(filePath);
+    editor->deferLoad(filePath, documentOptionsForFile(filePath));
+
+    return editor;
+}
+
+void EditorManager::prefetchDeferredEditors()
+{
+    qInfo(Q_FUNC_INFO);
+
+    purgeOldEditorPointers();
+
+    // Every read is queued at once and the pool runs them in that order. The editors are in tab order so the first
+    // tabs are read, and filled in, first.
+    ScintillaNext *previous = Q_NULLPTR;
+
+    for (ScintillaNext *editor : qAsConst(editors)) {
+        if (editor->isLoadDeferred()) {
+            qDebug("Prefetching \"%s\"", qUtf8Printable(editor->getFilePath()));
+
+            editor->prefetch(&prefetchPool, previous);
+            previous = editor;
+        }
+    }
+}
+
 void EditorManager::setupEditor(ScintillaNext *editor)
 {
     qInfo(Q_FUNC_INFO);
@@ -217,8 +316,9 @@ void EditorManager::setupEditor(ScintillaNext *editor)
     BraceMatch *b = new BraceMatch(editor);
     b->setEnabled(true);
 
+    // Paged editors number the lines themselves
     LineNumbers *l = new LineNumbers(editor);
-    l->setEnabled(true);
+    l->setEnabled(PagedFileView::forEditor(editor) == Q_NULLPTR);
 
     SurroundSelection *ss = new SurroundSelection(editor);
     ss->setEnabled(true);
@@ -237,6 +337,25 @@ void EditorManager::setupEditor(ScintillaNext *editor)
 
     BookMarkDecorator *bm = new BookMarkDecorator(editor);
     bm->setEnabled(true);
+
+    setupLargeFileProfile(editor);
+}
+
+void EditorManager::setupLargeFileProfile(ScintillaNext *editor)
+{
+    if (editor->isFile() && isLargeFile(editor->getFileInfo().size())) {
+        new LargeFileProfile(editor);
+        return;
+    }
+
+    // Long lines are only known about once the file has been read
+    if (editor->isLoading()) {
+        connect(editor, &ScintillaNext::loadFinished, this, [=](bool success) {
+            if (success && LargeFileProfile::forEditor(editor) == Q_NULLPTR && isLargeFile(editor->length(), editor->getFileAnalysis().longestLine)) {
+                new LargeFileProfile(editor);
+            }
+        });
+    }
 }
 
 void EditorManager::purgeOldEditorPointers()
@@ -22,16 +22,19 @@
 
 #include <QObject>
 #include <QPointer>
+#include <QThreadPool>
 
 
+class NotepadNextApplication;
 class ScintillaNext;
+class Settings;
 
 class EditorManager : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit EditorManager(QObject *parent = nullptr);
+    explicit EditorManager(NotepadNextApplication *app);
 
     ScintillaNext *createEditor(const QString &name);
     ScintillaNext *createEditorFromFile(const QString &filePath, bool tryToCreate=false);
@@ -40,15 +43,40 @@ public:
 
     void manageEditor(ScintillaNext *editor);
 
+    // Large files are opened with the large file profile
+    bool isLargeFile(qint64 size, qint64 longestLine = 0) const;
+
+    // Picks the document options before the file is loaded. Large and plain text files don't need
+    // styles, and files over 2 GB need 64-bit positions.
+    int documentOptionsForFile(const QString &filePath) const;
+
+    // Paged files are too big to load at all, only the part being viewed is read from disk
+    bool isPagedFile(qint64 size) const;
+
+    // Creates an unmanaged editor for the file, paged if needed
+    ScintillaNext *openFile(const QString &filePath, bool tryToCreate=false) const;
+
+    // Creates an unmanaged placeholder editor that doesn't read the file until it is needed
+    ScintillaNext *openFileDeferred(const QString &filePath) const;
+
+    // Reads every placeholder editor in the background, several files at a time, and fills them in in tab order
+    void prefetchDeferredEditors();
+
 signals:
     void editorCreated(ScintillaNext *editor);
     void editorClosed(ScintillaNext *editor);
 
 private:
     void setupEditor(ScintillaNext *editor);
+    void setupLargeFileProfile(ScintillaNext *editor);
     void purgeOldEditorPointers();
 
+    NotepadNextApplication *app;
+    Settings *settings;
     QList<QPointer<ScintillaNext>> editors;
+
+    // Kept apart from the global pool so files the user opens aren't queued behind the whole session
+    QThreadPool prefetchPool;
 };
 
 #endif // EDITORMANAGER_H
@@ -0,0 +1,181 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "EncodingWriter.h"
+
+
+const qint64 ENCODE_CHUNK_SIZE = 1024 * 1024 * 4;
+
+
+// Number of bytes at the end of the data that are an incomplete UTF-8 sequence
+static int incompleteSequenceLength(const char *data, qint64 length)
+{
+    for (int i = 1; i <= 3 && i <= length; ++i) {
+        const unsigned char c = static_cast<unsigned char>(data[length - i]);
+
+        if ((c & 0xC0) == 0x80) {
+            // Continuation byte, keep looking for the lead byte
+            continue;
+        }
+
+        if (c >= 0xC0) {
+            const int expected = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 2;
+            return expected > i ? i : 0;
+        }
+
+        return 0;
+    }
+
+    return 0;
+}
+
+EncodingWriter::EncodingWriter(QIODevice &device, const FileEncoding &encoding) :
+    device(device),
+    encoding(encoding),
+    state(QTextCodec::IgnoreHeader),
+    bomPending(encoding.hasBom)
+{
+    if (!encoding.isUtf8()) {
+        codec = QTextCodec::codecForName(encoding.codecName);
+
+        if (codec == Q_NULLPTR) {
+            qWarning("Unknown codec '%s', saving as UTF-8", encoding.codecName.constData());
+        }
+    }
+}
+
+bool EncodingWriter::write(const char *data, qint64 length)
+{
+    if (bomPending) {
+        bomPending = false;
+
+        if (!writeBom()) {
+            return false;
+        }
+    }
+
+    if (codec == Q_NULLPTR) {
+        return writeRaw(data, length);
+    }
+
+    // Finish off a character that was split across calls
+    if (!partial.isEmpty()) {
+        const unsigned char lead = static_cast<unsigned char>(partial.at(0));
+        const int expected = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : 2;
+
+        while (partial.size() < expected && length > 0 && (static_cast<unsigned char>(*data) & 0xC0) == 0x80) {
+            partial.append(*data);
+            ++data;
+            --length;
+        }
+
+        if (partial.size() < expected && length == 0) {
+            return true;
+        }
+
+        if (!writeEncoded(partial.constData(), partial.size())) {
+            return false;
+        }
+
+        partial.clear();
+    }
+
+    while (length > 0) {
+        const qint64 size = qMin(length, ENCODE_CHUNK_SIZE);
+        const bool isLast = size == length;
+
+        // Don't split a character between pieces
+        const qint64 complete = size - incompleteSequenceLength(data, size);
+
+        if (!writeEncoded(data, complete)) {
+            return false;
+        }
+
+        data += complete;
+        length -= complete;
+
+        // Hold on to an unfinished character until there is more data
+        if (isLast && length > 0) {
+            partial = QByteArray(data, static_cast<int>(length));
+            length = 0;
+        }
+    }
+
+    return true;
+}
+
+bool EncodingWriter::finish()
+{
+    if (bomPending) {
+        bomPending = false;
+
+        if (!writeBom()) {
+            return false;
+        }
+    }
+
+    // A dangling partial character gets converted however the codec sees fit
+    if (!partial.isEmpty()) {
+        const bool written = writeEncoded(partial.constData(), partial.size());
+        partial.clear();
+        return written;
+    }
+
+    return true;
+}
+
+bool EncodingWriter::writeEncoded(const char *data, qint64 length)
+{
+    if (length == 0) {
+        return true;
+    }
+
+    const QString text = QString::fromUtf8(data, static_cast<int>(length));
+    const QByteArray encoded = codec->fromUnicode(text.constData(), text.size(), &state);
+
+    return device.write(encoded) != -1;
+}
+
+bool EncodingWriter::writeRaw(const char *data, qint64 length)
+{
+    while (length > 0) {
+        const qint64 written = device.write(data, qMin(length, ENCODE_CHUNK_SIZE));
+
+        if (written == -1) {
+            return false;
+        }
+
+        data += written;
+        length -= written;
+    }
+
+    return true;
+}
+
+bool EncodingWriter::writeBom()
+{
+    const QChar bom(QChar::ByteOrderMark);
+
+    if (codec == Q_NULLPTR) {
+        return device.write("\xEF\xBB\xBF", 3) != -1;
+    }
+
+    QTextCodec::ConverterState bomState(QTextCodec::IgnoreHeader);
+    return device.write(codec->fromUnicode(&bom, 1, &bomState)) != -1;
+}
@@ -0,0 +1,55 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ENCODINGWRITER_H
+#define ENCODINGWRITER_H
+
+#include "FileReader.h"
+
+#include <QIODevice>
+#include <QTextCodec>
+
+
+// Writes UTF-8 text to a device in the file's original encoding. The text is converted a piece at a
+// time so memory use stays bounded no matter how large the document is.
+class EncodingWriter
+{
+public:
+    explicit EncodingWriter(QIODevice &device, const FileEncoding &encoding);
+
+    // UTF-8 sequences can be split across calls
+    bool write(const char *data, qint64 length);
+    bool finish();
+
+private:
+    bool writeEncoded(const char *data, qint64 length);
+    bool writeRaw(const char *data, qint64 length);
+    bool writeBom();
+
+    QIODevice &device;
+    FileEncoding encoding;
+
+    QTextCodec *codec = Q_NULLPTR;
+    QTextCodec::ConverterState state;
+
+    bool bomPending;
+    QByteArray partial;
+};
+
+#endif // ENCODINGWRITER_H
@@ -0,0 +1,171 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "FileChangeMonitor.h"
+#include "EditorManager.h"
+
+#include <QFileInfo>
+
+
+const int DEBOUNCE_INTERVAL = 250;
+
+
+FileChangeMonitor::FileChangeMonitor(EditorManager *manager, QObject *parent) :
+    QObject(parent)
+{
+    debounceTimer.setSingleShot(true);
+    debounceTimer.setInterval(DEBOUNCE_INTERVAL);
+
+    connect(&debounceTimer, &QTimer::timeout, this, &FileChangeMonitor::processPendingChanges);
+    connect(&watcher, &QFileSystemWatcher::fileChanged, this, &FileChangeMonitor::pathChanged);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &FileChangeMonitor::pathChanged);
+
+    connect(manager, &EditorManager::editorCreated, this, &FileChangeMonitor::watchEditor);
+    connect(manager, &EditorManager::editorClosed, this, &FileChangeMonitor::unwatchEditor);
+}
+
+bool FileChangeMonitor::isWatching(ScintillaNext *editor) const
+{
+    const QString path = editorPaths.value(editor);
+
+    return !path.isEmpty() && (watchedFiles.contains(path) || watchedDirectories.contains(QFileInfo(path).absolutePath()));
+}
+
+void FileChangeMonitor::watchEditor(ScintillaNext *editor)
+{
+    // The path can change any time the file is saved or renamed
+    connect(editor, &ScintillaNext::renamed, this, [=]() { updateEditorPath(editor); });
+    connect(editor, &ScintillaNext::saved, this, [=]() { updateEditorPath(editor); });
+
+    updateEditorPath(editor);
+}
+
+void FileChangeMonitor::unwatchEditor(ScintillaNext *editor)
+{
+    disconnect(editor, Q_NULLPTR, this, Q_NULLPTR);
+
+    unwatchPath(editorPaths.take(editor));
+}
+
+void FileChangeMonitor::pathChanged(const QString &path)
+{
+    pendingPaths.insert(path);
+
+    // Wait for things to settle down
+    debounceTimer.start();
+}
+
+void FileChangeMonitor::processPendingChanges()
+{
+    qInfo(Q_FUNC_INFO);
+
+    QList<ScintillaNext *> affectedEditors;
+
+    for (auto it = editorPaths.constBegin(); it != editorPaths.constEnd(); ++it) {
+        if (pendingPaths.contains(it.value()) || pendingPaths.contains(QFileInfo(it.value()).absolutePath())) {
+            affectedEditors.append(it.key());
+        }
+    }
+
+    pendingPaths.clear();
+
+    QList<Change> changes;
+
+    for (ScintillaNext *editor : qAsConst(affectedEditors)) {
+        const ScintillaNext::FileStateChange state = editor->checkFileForStateChange();
+
+        if (state != ScintillaNext::NoChange) {
+            changes.append({editor, state});
+        }
+
+        // Files that are replaced (e.g. by a safe save) or deleted are dropped by the watcher
+        updateEditorPath(editor);
+    }
+
+    if (!changes.isEmpty()) {
+        emit changesDetected(changes);
+    }
+}
+
+void FileChangeMonitor::updateEditorPath(ScintillaNext *editor)
+{
+    const QString oldPath = editorPaths.value(editor);
+    const QString newPath = pathOf(editor);
+
+    if (oldPath == newPath && watchedFiles.contains(newPath) && watcher.files().contains(newPath)) {
+        return;
+    }
+
+    unwatchPath(oldPath);
+
+    if (newPath.isEmpty()) {
+        editorPaths.remove(editor);
+    }
+    else {
+        editorPaths.insert(editor, newPath);
+        watchPath(newPath);
+    }
+}
+
+void FileChangeMonitor::watchPath(const QString &path)
+{
+    if (QFileInfo::exists(path)) {
+        if (watcher.addPath(path)) {
+            watchedFiles.insert(path);
+            return;
+        }
+
+        qWarning("Unable to watch \"%s\"", qUtf8Printable(path));
+    }
+
+    // Watch the directory instead so it is noticed if the file shows back up
+    const QString directory = QFileInfo(path).absolutePath();
+
+    if (watchedDirectories.contains(directory) || watcher.addPath(directory)) {
+        ++watchedDirectories[directory];
+    }
+}
+
+void FileChangeMonitor::unwatchPath(const QString &path)
+{
+    if (path.isEmpty()) {
+        return;
+    }
+
+    if (watchedFiles.remove(path)) {
+        watcher.removePath(path);
+        return;
+    }
+
+    const QString directory = QFileInfo(path).absolutePath();
+
+    if (watchedDirectories.contains(directory) && --watchedDirectories[directory] == 0) {
+        watchedDirectories.remove(directory);
+        watcher.removePath(directory);
+    }
+}
+
+QString FileChangeMonitor::pathOf(ScintillaNext *editor)
+{
+    if (editor->isFile()) {
+        return editor->getFileInfo().absoluteFilePath();
+    }
+
+    return QString();
+}
@@ -0,0 +1,77 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FILECHANGEMONITOR_H
+#define FILECHANGEMONITOR_H
+
+#include "ScintillaNext.h"
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+
+
+class EditorManager;
+
+// Watches the files of all open editors for changes made outside of the application. Notifications
+// are collected for a short time so a burst of writes only results in a single check per file.
+class FileChangeMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Change {
+        QPointer<ScintillaNext> editor;
+        ScintillaNext::FileStateChange state;
+    };
+
+    explicit FileChangeMonitor(EditorManager *manager, QObject *parent = nullptr);
+
+    // If it is not being watched (e.g. the OS limit was reached) then it needs to be checked manually
+    bool isWatching(ScintillaNext *editor) const;
+
+signals:
+    void changesDetected(const QList<FileChangeMonitor::Change> &changes);
+
+private slots:
+    void watchEditor(ScintillaNext *editor);
+    void unwatchEditor(ScintillaNext *editor);
+    void pathChanged(const QString &path);
+    void processPendingChanges();
+
+private:
+    void updateEditorPath(ScintillaNext *editor);
+    void watchPath(const QString &path);
+    void unwatchPath(const QString &path);
+    static QString pathOf(ScintillaNext *editor);
+
+    QFileSystemWatcher watcher;
+    QTimer debounceTimer;
+
+    QHash<ScintillaNext *, QString> editorPaths;
+    QSet<QString> watchedFiles;
+    QHash<QString, int> watchedDirectories;
+    QSet<QString> pendingPaths;
+};
+
+#endif // FILECHANGEMONITOR_H
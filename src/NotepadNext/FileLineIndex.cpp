@@ -0,0 +1,151 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "FileLineIndex.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+const qint64 INDEX_CHUNK_SIZE = 1024 * 1024 * 4;
+const qint64 SCAN_CHUNK_SIZE = 64 * 1024;
+
+
+bool FileLineIndex::build(const QString &filePath, const std::atomic_bool *canceled, std::atomic<qint64> *bytesProcessed)
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning("Unable to index \"%s\": %s", qUtf8Printable(filePath), qUtf8Printable(file.errorString()));
+        return false;
+    }
+
+    offsets.clear();
+    offsets.append(0);
+    lines = 1;
+    size = file.size();
+
+    QByteArray chunk(static_cast<int>(INDEX_CHUNK_SIZE), Qt::Uninitialized);
+    qint64 position = 0;
+
+    while (position < size) {
+        if (canceled && canceled->load()) {
+            return false;
+        }
+
+        const qint64 bytesRead = file.read(chunk.data(), INDEX_CHUNK_SIZE);
+
+        if (bytesRead <= 0) {
+            qWarning("Error indexing \"%s\": %s", qUtf8Printable(filePath), qUtf8Printable(file.errorString()));
+            return false;
+        }
+
+        const char *data = chunk.constData();
+        const char *end = data + bytesRead;
+        const char *newline = data;
+
+        while ((newline = static_cast<const char *>(memchr(newline, '\n', end - newline))) != Q_NULLPTR) {
+            ++newline;
+
+            if (lines % STRIDE == 0) {
+                offsets.append(position + (newline - data));
+            }
+
+            ++lines;
+        }
+
+        position += bytesRead;
+
+        if (bytesProcessed) {
+            bytesProcessed->store(position);
+        }
+    }
+
+    return true;
+}
+
+qint64 FileLineIndex::offsetOfLine(QFile &file, qint64 line) const
+{
+    line = qBound<qint64>(0, line, lines - 1);
+
+    qint64 position = offsets[static_cast<int>(line / STRIDE)];
+    qint64 remaining = line % STRIDE;
+
+    if (remaining == 0 || !file.seek(position)) {
+        return position;
+    }
+
+    char buffer[SCAN_CHUNK_SIZE];
+
+    while (remaining > 0) {
+        const qint64 bytesRead = file.read(buffer, SCAN_CHUNK_SIZE);
+
+        if (bytesRead <= 0) {
+            break;
+        }
+
+        const char *newline = buffer;
+        const char *end = buffer + bytesRead;
+
+        while (remaining > 0 && (newline = static_cast<const char *>(memchr(newline, '\n', end - newline))) != Q_NULLPTR) {
+            ++newline;
+            --remaining;
+        }
+
+        position += remaining == 0 ? newline - buffer : bytesRead;
+    }
+
+    return position;
+}
+
+qint64 FileLineIndex::lineOfOffset(QFile &file, qint64 offset) const
+{
+    offset = qBound<qint64>(0, offset, size);
+
+    // Find the closest indexed line before the offset, then count the rest
+    const auto it = std::upper_bound(offsets.constBegin(), offsets.constEnd(), offset) - 1;
+    qint64 line = (it - offsets.constBegin()) * STRIDE;
+    qint64 position = *it;
+
+    if (position == offset || !file.seek(position)) {
+        return line;
+    }
+
+    char buffer[SCAN_CHUNK_SIZE];
+
+    while (position < offset) {
+        const qint64 bytesRead = file.read(buffer, qMin(SCAN_CHUNK_SIZE, offset - position));
+
+        if (bytesRead <= 0) {
+            break;
+        }
+
+        const char *newline = buffer;
+        const char *end = buffer + bytesRead;
+
+        while ((newline = static_cast<const char *>(memchr(newline, '\n', end - newline))) != Q_NULLPTR) {
+            ++newline;
+            ++line;
+        }
+
+        position += bytesRead;
+    }
+
+    return line;
+}
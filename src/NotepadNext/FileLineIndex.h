@@ -0,0 +1,53 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FILELINEINDEX_H
+#define FILELINEINDEX_H
+
+#include <QFile>
+#include <QVector>
+
+#include <atomic>
+
+
+// A sparse index of where lines start in a file on disk. Only every STRIDE'th line is recorded, the
+// rest are found by scanning forward from the closest one, which keeps the index small enough for
+// files with billions of lines. Lines are split on \n.
+class FileLineIndex
+{
+public:
+    static const qint64 STRIDE = 1024;
+
+    // Safe to call from a worker thread
+    bool build(const QString &filePath, const std::atomic_bool *canceled = Q_NULLPTR, std::atomic<qint64> *bytesProcessed = Q_NULLPTR);
+
+    // Like Scintilla, there is always one more line than there are line endings
+    qint64 lineCount() const { return lines; }
+    qint64 fileSize() const { return size; }
+
+    qint64 offsetOfLine(QFile &file, qint64 line) const;
+    qint64 lineOfOffset(QFile &file, qint64 offset) const;
+
+private:
+    QVector<qint64> offsets;
+    qint64 lines = 1;
+    qint64 size = 0;
+};
+
+#endif // FILELINEINDEX_H
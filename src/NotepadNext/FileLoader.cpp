@@ -0,0 +1,171 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "FileLoader.h"
+#include "FileReader.h"
+#include "ScintillaNext.h"
+
+#include <QFileInfo>
+#include <QtConcurrent>
+
+
+FileLoader::FileLoader(ScintillaNext *editor, const QString &filePath, int documentOptions) :
+    QObject(editor),
+    filePath(filePath)
+{
+    fileSize = QFileInfo(filePath).size();
+
+    // The loader is a new document that is not attached to any view, so it can be filled from another thread
+    loader = reinterpret_cast<Scintilla::ILoader *>(editor->createLoader(fileSize, documentOptions));
+
+    progressTimer.setInterval(100);
+    connect(&progressTimer, &QTimer::timeout, this, &FileLoader::updateProgress);
+    connect(&watcher, &QFutureWatcher<bool>::finished, this, &FileLoader::readFinished);
+}
+
+FileLoader::~FileLoader()
+{
+    // The worker references members of this object so it has to be stopped before anything is destroyed
+    canceled = true;
+    watcher.waitForFinished();
+
+    releaseLoader();
+}
+
+void FileLoader::start(QThreadPool *pool)
+{
+    qInfo(Q_FUNC_INFO);
+
+    if (loader == Q_NULLPTR) {
+        qWarning("Unable to create a loader for \"%s\"", qUtf8Printable(filePath));
+        done = true;
+        QTimer::singleShot(0, this, [=]() { emit finished(false); });
+        return;
+    }
+
+    Scintilla::ILoader *l = loader;
+    LoadAnalyzer *a = &analyzer;
+    FileEncoding *e = &encoding;
+    const QString path = filePath;
+
+    watcher.setFuture(QtConcurrent::run(pool, [=]() {
+        QFile file(path);
+        FileReader reader(file);
+
+        reader.setCancelFlag(&canceled);
+        reader.setProgressCounter(&bytesRead);
+        reader.setAnalyzer(a);
+
+        const bool readSuccessful = reader.read([=](const char *data, qint64 length) {
+            return l->AddData(data, length) == SC_STATUS_OK;
+        });
+
+        *e = reader.getEncoding();
+
+        return readSuccessful;
+    }));
+
+    progressTimer.start();
+}
+
+void FileLoader::finishAfter(FileLoader *other)
+{
+    previous = other;
+}
+
+void FileLoader::waitForFinished()
+{
+    if (done || loader == Q_NULLPTR) {
+        return;
+    }
+
+    // Whatever is waiting needs it now, not once the loaders before it are done
+    previous.clear();
+
+    watcher.waitForFinished();
+
+    // The finished signal is queued, so handle it now rather than waiting on the event loop
+    readFinished();
+}
+
+void *FileLoader::takeDocument()
+{
+    Q_ASSERT(done);
+
+    if (loader == Q_NULLPTR) {
+        return Q_NULLPTR;
+    }
+
+    void *document = loader->ConvertToDocument();
+    loader = Q_NULLPTR;
+    return document;
+}
+
+void FileLoader::cancel()
+{
+    qInfo(Q_FUNC_INFO);
+
+    canceled = true;
+}
+
+void FileLoader::updateProgress()
+{
+    if (fileSize > 0) {
+        emit progressChanged(static_cast<int>(bytesRead * 100 / fileSize));
+    }
+}
+
+void FileLoader::readFinished()
+{
+    progressTimer.stop();
+
+    // This can get called twice if waitForFinished() beat the queued signal
+    if (done) {
+        return;
+    }
+
+    // Come back once the previous loader is finished, or gone if its editor was closed
+    if (previous && !previous->done) {
+        connect(previous, &FileLoader::finished, this, &FileLoader::readFinished, Qt::UniqueConnection);
+        connect(previous, &QObject::destroyed, this, &FileLoader::readFinished, Qt::UniqueConnection);
+        return;
+    }
+
+    done = true;
+
+    const bool success = watcher.result() && !canceled;
+
+    if (success) {
+        analysis = analyzer.finish();
+        emit progressChanged(100);
+    }
+    else {
+        releaseLoader();
+    }
+
+    emit finished(success);
+}
+
+void FileLoader::releaseLoader()
+{
+    if (loader) {
+        loader->Release();
+        loader = Q_NULLPTR;
+    }
+}
@@ -0,0 +1,97 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FILELOADER_H
+#define FILELOADER_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include <atomic>
+
+#include "ILoader.h"
+#include "FileReader.h"
+#include "LoadAnalyzer.h"
+
+
+class QThreadPool;
+class ScintillaNext;
+
+// Loads a file into a detached Scintilla document on a worker thread using SCI_CREATELOADER.
+// Once the read is complete the document can be taken and attached to the editor.
+class FileLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileLoader(ScintillaNext *editor, const QString &filePath, int documentOptions);
+    ~FileLoader() override;
+
+    void start(QThreadPool *pool);
+    void waitForFinished();
+
+    // Holds on to the result until the other loader has finished, so a batch of documents gets attached in order
+    void finishAfter(FileLoader *other);
+
+    bool isRunning() const { return watcher.isRunning(); }
+    QString getFilePath() const { return filePath; }
+
+    // Only valid once the load has successfully finished
+    FileAnalysis getAnalysis() const { return analysis; }
+    FileEncoding getEncoding() const { return encoding; }
+    qint64 getBytesRead() const { return bytesRead; }
+
+    // Ownership of the document is passed to the caller, it must be released once attached
+    void *takeDocument();
+
+public slots:
+    void cancel();
+
+signals:
+    void progressChanged(int percent);
+    void finished(bool success);
+
+private slots:
+    void updateProgress();
+    void readFinished();
+
+private:
+    void releaseLoader();
+
+    QString filePath;
+    qint64 fileSize = 0;
+
+    Scintilla::ILoader *loader = Q_NULLPTR;
+    bool done = false;
+    QPointer<FileLoader> previous;
+
+    QFutureWatcher<bool> watcher;
+    QTimer progressTimer;
+
+    std::atomic_bool canceled{false};
+    std::atomic<qint64> bytesRead{0};
+
+    LoadAnalyzer analyzer;
+    FileAnalysis analysis;
+    FileEncoding encoding;
+};
+
+#endif // FILELOADER_H
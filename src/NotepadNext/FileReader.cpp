@@ -0,0 +1,245 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "FileReader.h"
+#include "LoadAnalyzer.h"
+#include "Utf8Transcoder.h"
+#include "Utf8Validator.h"
+
+#include "uchardet.h"
+
+#include <QTextCodec>
+
+
+const int CHUNK_SIZE = 1024 * 1024 * 4; // Not sure what is best
+const int DETECTION_SIZE = 64 * 1024;
+const int UTF8_MIB = 106;
+const char UTF8_BOM[] = "\xEF\xBB\xBF";
+
+
+FileReader::FileReader(QFile &file) :
+    file(file)
+{
+}
+
+bool FileReader::read(const Sink &destination)
+{
+    const Sink sink = analyzer == Q_NULLPTR ? destination : Sink([&](const char *data, qint64 length) {
+        analyzer->addData(data, length);
+        return destination(data, length);
+    });
+
+    if (!file.exists()) {
+        qWarning("Cannot read \"%s\": doesn't exist", qUtf8Printable(file.fileName()));
+        return false;
+    }
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning("QFile::open() failed when opening \"%s\" - error code %d: %s", qUtf8Printable(file.fileName()), file.error(), qUtf8Printable(file.errorString()));
+        return false;
+    }
+
+    // Limit detection to the first 64 kilobytes
+    const QByteArray sample = file.read(DETECTION_SIZE);
+    file.seek(0);
+
+    // A BOM is definitive, otherwise the contents are checked to see if they are valid UTF-8
+    QTextCodec *codec = QTextCodec::codecForUtfText(sample, Q_NULLPTR);
+
+    if (codec != Q_NULLPTR) {
+        qDebug("BOM mark found");
+    }
+
+    bool readSuccessful = false;
+    uchar *data = Q_NULLPTR;
+    const qint64 size = file.size();
+
+    if (isUtf8Compatible(codec) && size > 0) {
+        data = file.map(0, size);
+
+        if (data == Q_NULLPTR) {
+            qDebug("QFile::map() failed, falling back to reading chunks: %s", qUtf8Printable(file.errorString()));
+        }
+    }
+
+    if (data != Q_NULLPTR) {
+        const qint64 offset = sample.startsWith(UTF8_BOM) ? qstrlen(UTF8_BOM) : 0;
+
+        // Only guess at the encoding when the file is not valid UTF-8 already
+        if (codec == Q_NULLPTR && !isValidUtf8(reinterpret_cast<const char *>(data + offset), size - offset)) {
+            codec = detectCodec(sample);
+        }
+
+        // UTF-8 is what Scintilla uses internally so there is nothing to convert, just hand it the file directly
+        if (isUtf8Compatible(codec)) {
+            setEncoding(Q_NULLPTR, offset > 0);
+            readSuccessful = readMapped(sink, data, offset, size);
+            file.unmap(data);
+            file.close();
+
+            return readSuccessful;
+        }
+
+        file.unmap(data);
+    }
+    else if (codec == Q_NULLPTR) {
+        codec = detectCodec(sample);
+    }
+
+    setEncoding(codec, QTextCodec::codecForUtfText(sample, Q_NULLPTR) != Q_NULLPTR);
+    readSuccessful = readChunked(sink, codec);
+
+    file.close();
+
+    return readSuccessful;
+}
+
+QTextCodec *FileReader::detectCodec(const QByteArray &sample)
+{
+    qDebug("Using uchardet");
+
+    QTextCodec *codec = Q_NULLPTR;
+
+    // Use uchardet to try and detect file encoding since no BOM was found
+    uchardet_t encodingDetector = uchardet_new();
+    if (uchardet_handle_data(encodingDetector, sample.data(), sample.size()) == 0) {
+        uchardet_data_end(encodingDetector);
+
+        const char *charset = uchardet_get_charset(encodingDetector);
+        qDebug("uchardet detected encoding as: '%s'", charset);
+
+        if (qstrcmp(charset, "ASCII") != 0) {
+            codec = QTextCodec::codecForName(charset);
+        }
+    }
+    else {
+        qDebug("uchardet failure");
+    }
+    uchardet_delete(encodingDetector);
+
+    qDebug("Using codec: '%s'", codec ? codec->name().constData() : "");
+
+    return codec;
+}
+
+bool FileReader::isValidUtf8(const char *data, qint64 length)
+{
+    const bool valid = Utf8Validator::isValid(data, length);
+
+    qDebug("UTF-8 validation of %lld bytes: %s", length, valid ? "valid" : "invalid");
+
+    return valid;
+}
+
+bool FileReader::isUtf8Compatible(const QTextCodec *codec)
+{
+    // No codec means the data gets passed through untouched (e.g. ASCII)
+    return codec == Q_NULLPTR || codec->mibEnum() == UTF8_MIB;
+}
+
+void FileReader::setEncoding(const QTextCodec *codec, bool hasBom)
+{
+    encoding.codecName = isUtf8Compatible(codec) ? QByteArray() : codec->name();
+    encoding.hasBom = hasBom;
+}
+
+bool FileReader::readMapped(const Sink &sink, const uchar *data, qint64 offset, qint64 size)
+{
+    qDebug("Reading %lld mapped bytes", size - offset);
+
+    // The sink still gets it in pieces so the progress can be reported and the read canceled
+    bool sinkAccepted = true;
+    qint64 position = offset;
+    while (position < size && sinkAccepted && !isCanceled()) {
+        const qint64 length = qMin<qint64>(CHUNK_SIZE, size - position);
+
+        sinkAccepted = sink(reinterpret_cast<const char *>(data + position), length);
+        position += length;
+
+        if (bytesProcessed) {
+            bytesProcessed->store(position);
+        }
+    }
+
+    bytesRead = position;
+
+    return sinkAccepted && !isCanceled();
+}
+
+bool FileReader::readChunked(const Sink &sink, QTextCodec *codec)
+{
+    QByteArray chunk;
+    QByteArray utf8_data;
+    qint64 chunkLength;
+    QTextCodec::ConverterState state;
+    bool sinkAccepted = true;
+
+    // Prefer converting directly to UTF-8, only the less common codecs need to go through QString
+    Utf8Transcoder transcoder(codec);
+    if (transcoder.isValid()) {
+        qDebug("Transcoding directly to UTF-8");
+    }
+
+    do {
+        // Try to read as much as possible
+        chunk.resize(CHUNK_SIZE);
+        chunkLength = file.read(chunk.data(), CHUNK_SIZE);
+
+        if (chunkLength == -1) {
+            break;
+        }
+
+        chunk.resize(chunkLength);
+
+        qDebug("Read %lld bytes", chunkLength);
+
+        if (transcoder.isValid()) {
+            transcoder.transcode(chunk.constData(), chunk.size(), utf8_data);
+            sinkAccepted = sink(utf8_data.constData(), utf8_data.size());
+        }
+        else if (codec) {
+            utf8_data = codec->toUnicode(chunk.constData(), chunk.size(), &state).toUtf8();
+            sinkAccepted = sink(utf8_data.constData(), utf8_data.size());
+        }
+        else {
+            sinkAccepted = sink(chunk.constData(), chunk.size());
+        }
+
+        if (bytesProcessed) {
+            bytesProcessed->store(file.pos());
+        }
+    } while (!file.atEnd() && sinkAccepted && !isCanceled());
+
+    if (chunkLength == -1) {
+        qWarning("Something bad happened when reading disk %d %s", file.error(), qUtf8Printable(file.errorString()));
+        return false;
+    }
+
+    bytesRead = file.pos();
+
+    if (transcoder.isValid() && sinkAccepted) {
+        transcoder.finish(utf8_data);
+
+        if (!utf8_data.isEmpty()) {
+            sinkAccepted = sink(utf8_data.constData(), utf8_data.size());
+        }
+    }
+
+    return sinkAccepted && !isCanceled();
+}
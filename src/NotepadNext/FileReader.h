@@ -0,0 +1,86 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FILEREADER_H
+#define FILEREADER_H
+
+#include <QFile>
+#include <QTextCodec>
+
+#include <atomic>
+#include <functional>
+
+
+class LoadAnalyzer;
+
+// The encoding the file was in on disk. Text in the editor is always UTF-8.
+struct FileEncoding {
+    // Empty means UTF-8
+    QByteArray codecName;
+    bool hasBom = false;
+
+    bool isUtf8() const { return codecName.isEmpty(); }
+};
+
+// Reads a file from disk, determines its encoding, and hands the contents to a sink as UTF-8.
+// It does not touch any widgets so it is safe to use from a worker thread.
+class FileReader
+{
+public:
+    // Return false from the sink to stop reading
+    typedef std::function<bool (const char *data, qint64 length)> Sink;
+
+    explicit FileReader(QFile &file);
+
+    void setCancelFlag(const std::atomic_bool *flag) { canceled = flag; }
+    void setProgressCounter(std::atomic<qint64> *counter) { bytesProcessed = counter; }
+
+    // Everything given to the sink is also given to the analyzer
+    void setAnalyzer(LoadAnalyzer *loadAnalyzer) { analyzer = loadAnalyzer; }
+
+    bool read(const Sink &destination);
+
+    // What the file was decoded from, only valid after read()
+    FileEncoding getEncoding() const { return encoding; }
+
+    // How far into the file was read, only valid after read()
+    qint64 getBytesRead() const { return bytesRead; }
+
+private:
+    bool isCanceled() const { return canceled && canceled->load(); }
+
+    static QTextCodec *detectCodec(const QByteArray &sample);
+    static bool isUtf8Compatible(const QTextCodec *codec);
+    void setEncoding(const QTextCodec *codec, bool hasBom);
+    static bool isValidUtf8(const char *data, qint64 length);
+
+    bool readMapped(const Sink &sink, const uchar *data, qint64 offset, qint64 size);
+    bool readChunked(const Sink &sink, QTextCodec *codec);
+
+    QFile &file;
+
+    const std::atomic_bool *canceled = Q_NULLPTR;
+    std::atomic<qint64> *bytesProcessed = Q_NULLPTR;
+    LoadAnalyzer *analyzer = Q_NULLPTR;
+
+    FileEncoding encoding;
+    qint64 bytesRead = 0;
+};
+
+#endif // FILEREADER_H
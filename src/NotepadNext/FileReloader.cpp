@@ -0,0 +1,224 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "FileReloader.h"
+
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+#include <cstring>
+
+
+const qint64 MAX_RELOAD_SIZE = 1024 * 1024 * 1024;
+
+
+namespace {
+
+// How much of the start of the pieces is the same as the start of data
+qint64 commonPrefix(const QVector<QByteArray> &pieces, const char *data, qint64 length)
+{
+    qint64 prefix = 0;
+
+    for (const QByteArray &piece : pieces) {
+        const qint64 count = qMin<qint64>(piece.size(), length - prefix);
+
+        if (memcmp(piece.constData(), data + prefix, count) != 0) {
+            qint64 i = 0;
+            while (piece[static_cast<int>(i)] == data[prefix + i]) {
+                ++i;
+            }
+
+            return prefix + i;
+        }
+
+        prefix += count;
+
+        if (count < piece.size()) {
+            break;
+        }
+    }
+
+    return prefix;
+}
+
+// How much of the end of the pieces is the same as the end of data
+qint64 commonSuffix(const QVector<QByteArray> &pieces, const char *dataEnd, qint64 length)
+{
+    qint64 suffix = 0;
+
+    for (int n = pieces.size() - 1; n >= 0; --n) {
+        const char *pieceEnd = pieces[n].constData() + pieces[n].size();
+        const qint64 count = qMin<qint64>(pieces[n].size(), length - suffix);
+
+        if (memcmp(pieceEnd - count, dataEnd - suffix - count, count) != 0) {
+            qint64 i = 0;
+            while (pieceEnd[-i - 1] == dataEnd[-suffix - i - 1]) {
+                ++i;
+            }
+
+            return suffix + i;
+        }
+
+        suffix += count;
+
+        if (count < pieces[n].size()) {
+            break;
+        }
+    }
+
+    return suffix;
+}
+
+}
+
+
+FileReloader::FileReloader(QObject *parent, const QString &filePath, const QVector<QByteArray> &snapshot) :
+    QObject(parent),
+    filePath(filePath),
+    snapshot(snapshot)
+{
+    connect(&watcher, &QFutureWatcher<bool>::finished, this, &FileReloader::readFinished);
+}
+
+FileReloader::~FileReloader()
+{
+    // The worker references members of this object so it has to be stopped before anything is destroyed
+    canceled = true;
+    watcher.waitForFinished();
+}
+
+void FileReloader::start()
+{
+    qInfo(Q_FUNC_INFO);
+
+    watcher.setFuture(QtConcurrent::run([=]() {
+        return run();
+    }));
+}
+
+void FileReloader::waitForFinished()
+{
+    if (done) {
+        return;
+    }
+
+    watcher.waitForFinished();
+
+    // The finished signal is queued, so handle it now rather than waiting on the event loop
+    readFinished();
+}
+
+bool FileReloader::canReload(qint64 size)
+{
+    return size <= MAX_RELOAD_SIZE;
+}
+
+bool FileReloader::run()
+{
+    QFile file(filePath);
+
+    if (!canReload(file.size())) {
+        qWarning("\"%s\" is too large to reload in the background", qUtf8Printable(filePath));
+        return false;
+    }
+
+    text.reserve(static_cast<int>(file.size()));
+
+    LoadAnalyzer analyzer;
+    FileReader reader(file);
+    reader.setCancelFlag(&canceled);
+    reader.setAnalyzer(&analyzer);
+
+    const bool readSuccessful = reader.read([=](const char *data, qint64 length) {
+        if (!canReload(text.size() + length)) {
+            return false;
+        }
+
+        text.append(data, static_cast<int>(length));
+        return true;
+    });
+
+    if (!readSuccessful || canceled) {
+        return false;
+    }
+
+    analysis = analyzer.finish();
+    encoding = reader.getEncoding();
+    bytesRead = reader.getBytesRead();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    qint64 oldSize = 0;
+    for (const QByteArray &piece : qAsConst(snapshot)) {
+        oldSize += piece.size();
+    }
+
+    // The diff needs the old text in one piece, but joining the whole snapshot would be yet another copy of
+    // the file. Usually only a small part changed, so skip what is the same at either end and only join the rest.
+    const qint64 shortest = qMin<qint64>(oldSize, text.size());
+    qint64 prefix = commonPrefix(snapshot, text.constData(), shortest);
+    qint64 suffix = commonSuffix(snapshot, text.constData() + text.size(), shortest - prefix);
+
+    // Lines are compared as a whole, so cut right after a \n that both texts share
+    prefix = prefix > 0 ? text.lastIndexOf('\n', static_cast<int>(prefix - 1)) + 1 : 0;
+
+    const int suffixNewline = text.indexOf('\n', static_cast<int>(text.size() - suffix));
+    suffix = suffixNewline != -1 ? text.size() - suffixNewline - 1 : 0;
+
+    QByteArray oldText;
+    oldText.reserve(static_cast<int>(oldSize - prefix - suffix));
+
+    qint64 pieceStart = 0;
+    for (const QByteArray &piece : qAsConst(snapshot)) {
+        const qint64 from = qMax(prefix, pieceStart);
+        const qint64 to = qMin(oldSize - suffix, pieceStart + piece.size());
+
+        if (from < to) {
+            oldText.append(piece.constData() + (from - pieceStart), static_cast<int>(to - from));
+        }
+
+        pieceStart += piece.size();
+    }
+
+    snapshot.clear();
+
+    hunks = TextDiff::diffLines(oldText.constData(), oldText.size(), text.constData() + prefix, text.size() - prefix - suffix);
+
+    for (TextDiff::Hunk &hunk : hunks) {
+        hunk.oldStart += prefix;
+        hunk.newStart += prefix;
+    }
+
+    qDebug("Found %d changed hunks in %lld ms", static_cast<int>(hunks.size()), timer.elapsed());
+
+    return !canceled;
+}
+
+void FileReloader::readFinished()
+{
+    // This can get called twice if waitForFinished() beat the queued signal
+    if (done) {
+        return;
+    }
+
+    done = true;
+
+    emit finished(watcher.result());
+}
@@ -0,0 +1,82 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FILERELOADER_H
+#define FILERELOADER_H
+
+#include "FileReader.h"
+#include "LoadAnalyzer.h"
+#include "TextDiff.h"
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QVector>
+
+#include <atomic>
+
+
+// Reads a file again on a worker thread and works out the smallest set of changes that turn the
+// snapshot of the editor's text into the new contents, so only those need applied to the document.
+class FileReloader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileReloader(QObject *parent, const QString &filePath, const QVector<QByteArray> &snapshot);
+    ~FileReloader() override;
+
+    void start();
+    void waitForFinished();
+
+    QString getFilePath() const { return filePath; }
+
+    // Only valid once the reload has successfully finished. The hunks refer to ranges in the new text.
+    const QByteArray &getText() const { return text; }
+    const QVector<TextDiff::Hunk> &getHunks() const { return hunks; }
+    FileAnalysis getAnalysis() const { return analysis; }
+    FileEncoding getEncoding() const { return encoding; }
+    qint64 getBytesRead() const { return bytesRead; }
+
+    // The text has to fit in a single QByteArray
+    static bool canReload(qint64 size);
+
+signals:
+    void finished(bool success);
+
+private slots:
+    void readFinished();
+
+private:
+    bool run();
+
+    QString filePath;
+    QVector<QByteArray> snapshot;
+
+    bool done = false;
+    QFutureWatcher<bool> watcher;
+    std::atomic_bool canceled{false};
+
+    QByteArray text;
+    QVector<TextDiff::Hunk> hunks;
+    FileAnalysis analysis;
+    FileEncoding encoding;
+    qint64 bytesRead = 0;
+};
+
+#endif // FILERELOADER_H
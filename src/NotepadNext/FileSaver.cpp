@@ -0,0 +1,106 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "FileSaver.h"
+#include "EncodingWriter.h"
+
+#include <QSaveFile>
+#include <QtConcurrent>
+
+
+FileSaver::FileSaver(QObject *parent, const QString &filePath, const QVector<QByteArray> &snapshot, const FileEncoding &encoding) :
+    QObject(parent),
+    filePath(filePath),
+    snapshot(snapshot),
+    encoding(encoding)
+{
+    connect(&watcher, &QFutureWatcher<QFileDevice::FileError>::finished, this, &FileSaver::writeFinished);
+}
+
+FileSaver::~FileSaver()
+{
+    // Never abandon a write part way through
+    watcher.waitForFinished();
+}
+
+void FileSaver::start()
+{
+    qInfo(Q_FUNC_INFO);
+
+    const QString path = filePath;
+    const QVector<QByteArray> data = snapshot;
+    const FileEncoding fileEncoding = encoding;
+
+    watcher.setFuture(QtConcurrent::run([=]() {
+        return write(path, data, fileEncoding);
+    }));
+}
+
+void FileSaver::waitForFinished()
+{
+    if (done) {
+        return;
+    }
+
+    watcher.waitForFinished();
+
+    // The finished signal is queued, so handle it now rather than waiting on the event loop
+    writeFinished();
+}
+
+QFileDevice::FileError FileSaver::write(const QString &filePath, const QVector<QByteArray> &snapshot, const FileEncoding &encoding)
+{
+    QSaveFile file(filePath);
+    file.setDirectWriteFallback(true);
+
+    if (file.open(QIODevice::WriteOnly)) {
+        EncodingWriter writer(file, encoding);
+        bool writeSuccessful = true;
+
+        for (const QByteArray &chunk : snapshot) {
+            if (!writer.write(chunk.constData(), chunk.size())) {
+                writeSuccessful = false;
+                break;
+            }
+        }
+
+        if (writeSuccessful && writer.finish() && file.commit()) {
+            return QFileDevice::NoError;
+        }
+    }
+
+    // If it got to this point there was an error
+    qWarning("FileSaver::write() failure code %d: %s", file.error(), qPrintable(file.errorString()));
+    return file.error();
+}
+
+void FileSaver::writeFinished()
+{
+    // This can get called twice if waitForFinished() beat the queued signal
+    if (done) {
+        return;
+    }
+
+    done = true;
+
+    // Nothing else needs the copy
+    snapshot.clear();
+
+    emit finished(watcher.result());
+}
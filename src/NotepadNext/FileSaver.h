@@ -0,0 +1,63 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FILESAVER_H
+#define FILESAVER_H
+
+#include "FileReader.h"
+
+#include <QFileDevice>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QVector>
+
+
+// Writes a snapshot of a document to disk on a worker thread. The snapshot is a private copy so the
+// editor is free to keep changing while the write is in progress.
+class FileSaver : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileSaver(QObject *parent, const QString &filePath, const QVector<QByteArray> &snapshot, const FileEncoding &encoding);
+    ~FileSaver() override;
+
+    void start();
+    void waitForFinished();
+
+    QString getFilePath() const { return filePath; }
+
+    static QFileDevice::FileError write(const QString &filePath, const QVector<QByteArray> &snapshot, const FileEncoding &encoding);
+
+signals:
+    void finished(QFileDevice::FileError error);
+
+private slots:
+    void writeFinished();
+
+private:
+    QString filePath;
+    QVector<QByteArray> snapshot;
+    FileEncoding encoding;
+
+    bool done = false;
+    QFutureWatcher<QFileDevice::FileError> watcher;
+};
+
+#endif // FILESAVER_H
@@ -0,0 +1,122 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "LargeFileProfile.h"
+#include "ScintillaNext.h"
+
+#include "AutoCompletion.h"
+#include "BraceMatch.h"
+#include "HighlightedScrollBar.h"
+#include "SmartHighlighter.h"
+#include "URLFinder.h"
+
+
+LargeFileProfile::LargeFileProfile(ScintillaNext *editor) :
+    QObject(editor),
+    editor(editor)
+{
+    qInfo(Q_FUNC_INFO);
+
+    disabled = {SyntaxHighlighting, CodeFolding, WordWrap, SmartHighlighting, ScrollBarHighlighting, BraceMatching, WordCompletion, UrlDetection};
+
+    for (Feature feature : qAsConst(disabled)) {
+        setDecoratorEnabled(feature, false);
+    }
+
+    // The lexer and folding get handled when the language is set
+    editor->setWrapMode(SC_WRAP_NONE);
+}
+
+LargeFileProfile *LargeFileProfile::forEditor(const ScintillaNext *editor)
+{
+    return editor->findChild<LargeFileProfile *>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+bool LargeFileProfile::isFeatureDisabled(const ScintillaNext *editor, Feature feature)
+{
+    const LargeFileProfile *profile = forEditor(editor);
+
+    return profile != Q_NULLPTR && profile->isDisabled(feature);
+}
+
+QString LargeFileProfile::featureName(Feature feature)
+{
+    switch (feature) {
+    case SyntaxHighlighting:
+        return tr("Syntax Highlighting");
+    case CodeFolding:
+        return tr("Code Folding");
+    case WordWrap:
+        return tr("Word Wrap");
+    case SmartHighlighting:
+        return tr("Smart Highlighting");
+    case ScrollBarHighlighting:
+        return tr("Scroll Bar Highlighting");
+    case BraceMatching:
+        return tr("Brace Matching");
+    case WordCompletion:
+        return tr("Auto Completion");
+    case UrlDetection:
+        return tr("URL Detection");
+    }
+
+    return QString();
+}
+
+void LargeFileProfile::enable(Feature feature)
+{
+    qInfo(Q_FUNC_INFO);
+
+    if (!disabled.removeOne(feature)) {
+        return;
+    }
+
+    setDecoratorEnabled(feature, true);
+
+    emit featureEnabled(feature);
+}
+
+void LargeFileProfile::setDecoratorEnabled(Feature feature, bool enabled)
+{
+    EditorDecorator *decorator = Q_NULLPTR;
+
+    switch (feature) {
+    case SmartHighlighting:
+        decorator = editor->findChild<SmartHighlighter *>();
+        break;
+    case ScrollBarHighlighting:
+        decorator = editor->findChild<HighlightedScrollBarDecorator *>();
+        break;
+    case BraceMatching:
+        decorator = editor->findChild<BraceMatch *>();
+        break;
+    case WordCompletion:
+        decorator = editor->findChild<AutoCompletion *>();
+        break;
+    case UrlDetection:
+        decorator = editor->findChild<URLFinder *>();
+        break;
+    default:
+        break;
+    }
+
+    if (decorator) {
+        decorator->setEnabled(enabled);
+    }
+}
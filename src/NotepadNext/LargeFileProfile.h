@@ -0,0 +1,71 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LARGEFILEPROFILE_H
+#define LARGEFILEPROFILE_H
+
+#include <QList>
+#include <QObject>
+
+
+class ScintillaNext;
+
+// Attached to editors holding very large files. It turns off the features that get too slow with that
+// much text, each of which can be turned back on individually.
+class LargeFileProfile : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Feature {
+        SyntaxHighlighting,
+        CodeFolding,
+        WordWrap,
+        SmartHighlighting,
+        ScrollBarHighlighting,
+        BraceMatching,
+        WordCompletion,
+        UrlDetection,
+    };
+
+    explicit LargeFileProfile(ScintillaNext *editor);
+
+    // Null if the editor is not using the profile
+    static LargeFileProfile *forEditor(const ScintillaNext *editor);
+    static bool isFeatureDisabled(const ScintillaNext *editor, Feature feature);
+
+    static QString featureName(Feature feature);
+
+    QList<Feature> disabledFeatures() const { return disabled; }
+    bool isDisabled(Feature feature) const { return disabled.contains(feature); }
+
+public slots:
+    void enable(LargeFileProfile::Feature feature);
+
+signals:
+    void featureEnabled(LargeFileProfile::Feature feature);
+
+private:
+    void setDecoratorEnabled(Feature feature, bool enabled);
+
+    ScintillaNext *editor;
+    QList<Feature> disabled;
+};
+
+#endif // LARGEFILEPROFILE_H
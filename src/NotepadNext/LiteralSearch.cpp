@@ -0,0 +1,542 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "LiteralSearch.h"
+#include "SimdHelpers.h"
+#include "Utf8Validator.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "UniConversion.h"
+#include "CaseConvert.h"
+
+using namespace Scintilla::Internal;
+
+using LiteralSearch::FoldedSearch;
+
+
+namespace {
+
+typedef qint64 (*IndexOfFunction)(const char *haystack, qint64 length, const char *needle, qint64 needleLength);
+
+// Only called with needleLength >= 2 and length >= needleLength
+qint64 indexOfScalar(const char *haystack, qint64 length, const char *needle, qint64 needleLength)
+{
+    const qint64 last = length - needleLength;
+    qint64 i = 0;
+
+    while (i <= last) {
+        const void *found = memchr(haystack + i, needle[0], static_cast<size_t>(last - i + 1));
+
+        if (found == Q_NULLPTR) {
+            break;
+        }
+
+        i = static_cast<const char *>(found) - haystack;
+
+        if (memcmp(haystack + i + 1, needle + 1, static_cast<size_t>(needleLength - 1)) == 0) {
+            return i;
+        }
+
+        ++i;
+    }
+
+    return -1;
+}
+
+#ifdef NN_SIMD_SSE2
+qint64 indexOfSse2(const char *haystack, qint64 length, const char *needle, qint64 needleLength)
+{
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needleLength - 1]);
+    qint64 i = 0;
+
+    for (; i + needleLength - 1 + 16 <= length; i += 16) {
+        const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack + i));
+        const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack + i + needleLength - 1));
+        quint32 mask = static_cast<quint32>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast))));
+
+        while (mask != 0) {
+            const qint64 candidate = i + qCountTrailingZeroBits(mask);
+
+            // The first and last bytes already match
+            if (memcmp(haystack + candidate + 1, needle + 1, static_cast<size_t>(needleLength - 2)) == 0) {
+                return candidate;
+            }
+
+            mask &= mask - 1;
+        }
+    }
+
+    const qint64 tail = indexOfScalar(haystack + i, length - i, needle, needleLength);
+    return tail == -1 ? -1 : i + tail;
+}
+#endif
+
+#ifdef NN_SIMD_AVX2
+NN_TARGET_AVX2 qint64 indexOfAvx2(const char *haystack, qint64 length, const char *needle, qint64 needleLength)
+{
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[needleLength - 1]);
+    qint64 i = 0;
+
+    for (; i + needleLength - 1 + 32 <= length; i += 32) {
+        const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack + i));
+        const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack + i + needleLength - 1));
+        quint32 mask = static_cast<quint32>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast))));
+
+        while (mask != 0) {
+            const qint64 candidate = i + qCountTrailingZeroBits(mask);
+
+            // The first and last bytes already match
+            if (memcmp(haystack + candidate + 1, needle + 1, static_cast<size_t>(needleLength - 2)) == 0) {
+                return candidate;
+            }
+
+            mask &= mask - 1;
+        }
+    }
+
+    const qint64 tail = indexOfScalar(haystack + i, length - i, needle, needleLength);
+    return tail == -1 ? -1 : i + tail;
+}
+#endif
+
+IndexOfFunction selectIndexOf()
+{
+#ifdef NN_SIMD_AVX2
+    if (SimdHelpers::hasAvx2()) {
+        return indexOfAvx2;
+    }
+#endif
+#ifdef NN_SIMD_SSE2
+    return indexOfSse2;
+#else
+    return indexOfScalar;
+#endif
+}
+
+const int MAX_STARTS = 8;
+const int FOLD_TABLE_SIZE = 0x800;
+const int LAST_CASED_CHARACTER = 0x1FFFF;
+
+typedef std::pair<unsigned char, unsigned char> Start;
+typedef qint64 (*CandidateFunction)(const unsigned char *haystack, qint64 length, qint64 from, const Start *starts, int count, bool firstByteOnly);
+
+struct FoldTables
+{
+    FoldTables();
+
+    // What each character below U+0800 folds to, which covers ASCII, Latin, Greek, Cyrillic, Armenian,
+    // Hebrew and Arabic. Null if it folds to itself.
+    const char *folded[FOLD_TABLE_SIZE];
+    unsigned char foldedLength[FOLD_TABLE_SIZE];
+
+    // Every character that folds to something other than itself, as (folded, character)
+    std::vector<std::pair<std::string, std::string>> unfolded;
+
+    // The most bytes a character can take up in the document for each byte it folds to
+    qint64 maximumExpansion = 1;
+};
+
+FoldTables::FoldTables()
+{
+    char character[UTF8MaxBytes + 1];
+
+    for (int ch = 0; ch <= LAST_CASED_CHARACTER; ++ch) {
+        // Skip the UTF-16 surrogates
+        if (ch >= 0xD800 && ch <= 0xDFFF) {
+            continue;
+        }
+
+        const char *conversion = CaseConvert(ch, CaseConversion::fold);
+        const size_t conversionLength = conversion ? strlen(conversion) : 0;
+
+        if (ch < FOLD_TABLE_SIZE) {
+            folded[ch] = conversion;
+            foldedLength[ch] = static_cast<unsigned char>(conversionLength);
+        }
+
+        if (conversion == Q_NULLPTR) {
+            continue;
+        }
+
+        UTF8FromUTF32Character(ch, character);
+        const size_t characterLength = strlen(character);
+
+        unfolded.emplace_back(std::string(conversion, conversionLength), std::string(character, characterLength));
+        maximumExpansion = qMax<qint64>(maximumExpansion, (characterLength + conversionLength - 1) / conversionLength);
+    }
+}
+
+const FoldTables &foldTables()
+{
+    static const FoldTables tables;
+    return tables;
+}
+
+inline unsigned char makeLowerCase(unsigned char ch)
+{
+    return (ch >= 'A' && ch <= 'Z') ? ch - 'A' + 'a' : ch;
+}
+
+// Folds the character at data the same way Document::FindText() does and returns how many bytes it takes
+// up in the document, or 0 if it goes past the end
+inline int foldCharacter(const unsigned char *data, qint64 remaining, const char **folded, size_t *foldedLength, char *lowered)
+{
+    const unsigned char lead = data[0];
+
+    if (UTF8IsAscii(lead)) {
+        *lowered = static_cast<char>(makeLowerCase(lead));
+        *folded = lowered;
+        *foldedLength = 1;
+        return 1;
+    }
+
+    unsigned char bytes[UTF8MaxBytes] {lead};
+    const int widthCharBytes = UTF8BytesOfLead[lead];
+    for (int b = 1; b < widthCharBytes; ++b) {
+        bytes[b] = b < remaining ? data[b] : 0;
+    }
+
+    const int width = UTF8Classify(bytes, widthCharBytes) & UTF8MaskWidth;
+
+    if (width > remaining) {
+        return 0;
+    }
+
+    // Invalid bytes are a single character that folds to itself
+    const char *conversion = Q_NULLPTR;
+    size_t conversionLength = 0;
+
+    if (width > 1) {
+        const int ch = UnicodeFromUTF8(bytes);
+
+        if (ch < FOLD_TABLE_SIZE) {
+            conversion = foldTables().folded[ch];
+            conversionLength = foldTables().foldedLength[ch];
+        }
+        else {
+            conversion = CaseConvert(ch, CaseConversion::fold);
+            conversionLength = conversion ? strlen(conversion) : 0;
+        }
+    }
+
+    if (conversion) {
+        *folded = conversion;
+        *foldedLength = conversionLength;
+    }
+    else {
+        *folded = reinterpret_cast<const char *>(data);
+        *foldedLength = width;
+    }
+
+    return width;
+}
+
+// Every character in the document that can fold to the start of text, as (character, folded length)
+std::vector<std::pair<std::string, size_t>> startingCharacters(std::string_view text)
+{
+    std::vector<std::pair<std::string, size_t>> characters;
+
+    for (const auto &entry : foldTables().unfolded) {
+        if (text.compare(0, entry.first.size(), entry.first) == 0) {
+            characters.emplace_back(entry.second, entry.first.size());
+        }
+    }
+
+    const unsigned char lead = text[0];
+    const int classified = UTF8Classify(text);
+
+    if (!(classified & UTF8MaskInvalid)) {
+        const int width = classified & UTF8MaskWidth;
+        const int ch = UnicodeFromUTF8(reinterpret_cast<const unsigned char *>(text.data()));
+
+        // The character itself, unless it gets folded to something else
+        if (CaseConvert(ch, CaseConversion::fold) == Q_NULLPTR) {
+            characters.emplace_back(std::string(text.substr(0, width)), width);
+        }
+    }
+
+    // Invalid bytes in the document fold to themselves, so a single byte can match too
+    if (!UTF8IsAscii(lead)) {
+        characters.emplace_back(std::string(1, static_cast<char>(lead)), 1);
+    }
+
+    return characters;
+}
+
+qint64 nextCandidateScalar(const unsigned char *haystack, qint64 length, qint64 from, const Start *starts, int count, bool firstByteOnly)
+{
+    // Matches are at least two bytes long unless only the first byte is being checked
+    const qint64 end = firstByteOnly ? length : length - 1;
+
+    for (qint64 i = from; i < end; ++i) {
+        for (int k = 0; k < count; ++k) {
+            if (haystack[i] == starts[k].first && (firstByteOnly || haystack[i + 1] == starts[k].second)) {
+                return i;
+            }
+        }
+    }
+
+    return -1;
+}
+
+#ifdef NN_SIMD_SSE2
+qint64 nextCandidateSse2(const unsigned char *haystack, qint64 length, qint64 from, const Start *starts, int count, bool firstByteOnly)
+{
+    __m128i first[MAX_STARTS];
+    __m128i second[MAX_STARTS];
+
+    for (int k = 0; k < count; ++k) {
+        first[k] = _mm_set1_epi8(static_cast<char>(starts[k].first));
+        second[k] = _mm_set1_epi8(static_cast<char>(starts[k].second));
+    }
+
+    const qint64 extra = firstByteOnly ? 0 : 1;
+    qint64 i = from;
+
+    for (; i + extra + 16 <= length; i += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack + i));
+        const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack + i + extra));
+        __m128i hits = _mm_setzero_si128();
+
+        for (int k = 0; k < count; ++k) {
+            __m128i hit = _mm_cmpeq_epi8(block, first[k]);
+
+            if (!firstByteOnly) {
+                hit = _mm_and_si128(hit, _mm_cmpeq_epi8(next, second[k]));
+            }
+
+            hits = _mm_or_si128(hits, hit);
+        }
+
+        const int mask = _mm_movemask_epi8(hits);
+
+        if (mask != 0) {
+            return i + qCountTrailingZeroBits(static_cast<quint32>(mask));
+        }
+    }
+
+    return nextCandidateScalar(haystack, length, i, starts, count, firstByteOnly);
+}
+#endif
+
+#ifdef NN_SIMD_AVX2
+NN_TARGET_AVX2 qint64 nextCandidateAvx2(const unsigned char *haystack, qint64 length, qint64 from, const Start *starts, int count, bool firstByteOnly)
+{
+    __m256i first[MAX_STARTS];
+    __m256i second[MAX_STARTS];
+
+    for (int k = 0; k < count; ++k) {
+        first[k] = _mm256_set1_epi8(static_cast<char>(starts[k].first));
+        second[k] = _mm256_set1_epi8(static_cast<char>(starts[k].second));
+    }
+
+    const qint64 extra = firstByteOnly ? 0 : 1;
+    qint64 i = from;
+
+    for (; i + extra + 32 <= length; i += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack + i));
+        const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack + i + extra));
+        __m256i hits = _mm256_setzero_si256();
+
+        for (int k = 0; k < count; ++k) {
+            __m256i hit = _mm256_cmpeq_epi8(block, first[k]);
+
+            if (!firstByteOnly) {
+                hit = _mm256_and_si256(hit, _mm256_cmpeq_epi8(next, second[k]));
+            }
+
+            hits = _mm256_or_si256(hits, hit);
+        }
+
+        const quint32 mask = static_cast<quint32>(_mm256_movemask_epi8(hits));
+
+        if (mask != 0) {
+            return i + qCountTrailingZeroBits(mask);
+        }
+    }
+
+    return nextCandidateScalar(haystack, length, i, starts, count, firstByteOnly);
+}
+#endif
+
+CandidateFunction selectNextCandidate()
+{
+#ifdef NN_SIMD_AVX2
+    if (SimdHelpers::hasAvx2()) {
+        return nextCandidateAvx2;
+    }
+#endif
+#ifdef NN_SIMD_SSE2
+    return nextCandidateSse2;
+#else
+    return nextCandidateScalar;
+#endif
+}
+
+}
+
+qint64 LiteralSearch::indexOf(const char *haystack, qint64 length, const char *needle, qint64 needleLength)
+{
+    static const IndexOfFunction indexOfFunction = selectIndexOf();
+
+    if (needleLength <= 0 || needleLength > length) {
+        return -1;
+    }
+
+    // The C library's memchr() is already vectorized
+    if (needleLength == 1) {
+        const void *found = memchr(haystack, needle[0], static_cast<size_t>(length));
+        return found == Q_NULLPTR ? -1 : static_cast<const char *>(found) - haystack;
+    }
+
+    return indexOfFunction(haystack, length, needle, needleLength);
+}
+
+FoldedSearch::FoldedSearch(const QByteArray &text) :
+    original(text)
+{
+    if (text.isEmpty() || !Utf8Validator::isValid(text.constData(), text.size())) {
+        return;
+    }
+
+    // Fold it the same way Document::FindText() does, which only lowers ASCII for a single byte
+    if (text.size() == 1) {
+        folded = QByteArray(1, static_cast<char>(makeLowerCase(text[0])));
+    }
+    else {
+        // Worst case is every 2 bytes expanding to 6, plus room for Scintilla's check for running out of space
+        folded.resize(static_cast<int>(text.size() * maxExpansionCaseConversion + 1));
+        folded.resize(static_cast<int>(CaseConvertString(folded.data(), folded.size(), text.constData(), text.size(), CaseConversion::fold)));
+    }
+
+    if (folded.isEmpty()) {
+        return;
+    }
+
+    // Work out every possible pair of bytes a match can start with
+    const std::string_view foldedText(folded.constData(), folded.size());
+
+    for (const auto &character : startingCharacters(foldedText)) {
+        const unsigned char first = character.first[0];
+
+        if (character.first.size() > 1) {
+            starts.emplace_back(first, character.first[1]);
+        }
+        else if (character.second == foldedText.size()) {
+            // This one character is a whole match, so there is no second byte to check
+            starts.emplace_back(first, 0);
+            firstByteOnly = true;
+        }
+        else {
+            for (const auto &next : startingCharacters(foldedText.substr(character.second))) {
+                starts.emplace_back(first, next.first[0]);
+            }
+        }
+    }
+
+    if (firstByteOnly || starts.size() > MAX_STARTS) {
+        firstByteOnly = true;
+
+        for (Start &start : starts) {
+            start.second = 0;
+        }
+    }
+
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+
+    valid = true;
+}
+
+qint64 FoldedSearch::maximumMatchLength() const
+{
+    return folded.size() * foldTables().maximumExpansion;
+}
+
+qint64 FoldedSearch::indexIn(const char *haystack, qint64 length, qint64 *matchLength) const
+{
+    if (!valid) {
+        return -1;
+    }
+
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(haystack);
+    qint64 pos = 0;
+
+    while ((pos = nextCandidate(data, length, pos)) != -1) {
+        const qint64 matched = matchAt(data, length, pos);
+
+        if (matched != -1) {
+            *matchLength = matched;
+            return pos;
+        }
+
+        ++pos;
+    }
+
+    return -1;
+}
+
+qint64 FoldedSearch::nextCandidate(const unsigned char *haystack, qint64 length, qint64 from) const
+{
+    static const CandidateFunction nextCandidateFunction = selectNextCandidate();
+
+    const int count = static_cast<int>(starts.size());
+
+    if (count > MAX_STARTS) {
+        return nextCandidateScalar(haystack, length, from, starts.data(), count, firstByteOnly);
+    }
+
+    return nextCandidateFunction(haystack, length, from, starts.data(), count, firstByteOnly);
+}
+
+qint64 FoldedSearch::matchAt(const unsigned char *haystack, qint64 length, qint64 pos) const
+{
+    const char *text = folded.constData();
+    const size_t textLength = folded.size();
+    size_t index = 0;
+    qint64 end = pos;
+
+    while (index < textLength) {
+        if (end >= length) {
+            return -1;
+        }
+
+        const char *characterFolded;
+        size_t characterFoldedLength;
+        char lowered;
+        const int width = foldCharacter(haystack + end, length - end, &characterFolded, &characterFoldedLength, &lowered);
+
+        if (width == 0 || characterFoldedLength > textLength - index || memcmp(characterFolded, text + index, characterFoldedLength) != 0) {
+            return -1;
+        }
+
+        end += width;
+        index += characterFoldedLength;
+    }
+
+    return end - pos;
+}
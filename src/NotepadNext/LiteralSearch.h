@@ -0,0 +1,70 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LITERALSEARCH_H
+#define LITERALSEARCH_H
+
+#include <QByteArray>
+
+#include <utility>
+#include <vector>
+
+namespace LiteralSearch
+{
+    // Returns the offset of the first occurrence of needle in haystack, or -1 if there is none.
+    // Candidates are found by comparing the needle's first and last bytes 16 or 32 positions at a
+    // time when SSE2/AVX2 are available, and only those are checked with memcmp().
+    qint64 indexOf(const char *haystack, qint64 length, const char *needle, qint64 needleLength);
+
+    // Case insensitive search of UTF-8 text that finds exactly what Scintilla's CaseFolderUnicode does,
+    // including characters that fold to more than one character (e.g. ß and "ss") or to ASCII
+    // (e.g. the Kelvin sign and "k"). Every character that can start a match is worked out up front, so
+    // candidates are found by testing their first two bytes 16 or 32 positions at a time. Only those are
+    // then folded and compared, using a table for the two byte characters.
+    class FoldedSearch
+    {
+    public:
+        FoldedSearch() = default;
+        explicit FoldedSearch(const QByteArray &text);
+
+        // False if the text is not valid UTF-8
+        bool isValid() const { return valid; }
+        QByteArray text() const { return original; }
+
+        // The most bytes of the document a match can cover
+        qint64 maximumMatchLength() const;
+
+        // Returns the offset of the first match in haystack and sets its length, or -1 if there is none
+        qint64 indexIn(const char *haystack, qint64 length, qint64 *matchLength) const;
+
+    private:
+        qint64 nextCandidate(const unsigned char *haystack, qint64 length, qint64 from) const;
+        qint64 matchAt(const unsigned char *haystack, qint64 length, qint64 pos) const;
+
+        QByteArray original;
+        QByteArray folded;
+        bool valid = false;
+
+        // The possible first two bytes of a match, or only the first bytes if firstByteOnly is set
+        std::vector<std::pair<unsigned char, unsigned char>> starts;
+        bool firstByteOnly = false;
+    };
+}
+
+#endif // LITERALSEARCH_H
@@ -0,0 +1,195 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "LoadAnalyzer.h"
+#include "SimdHelpers.h"
+
+#include "Scintilla.h"
+
+#include <QtAlgorithms>
+
+
+namespace {
+
+inline bool isSpecial(char c)
+{
+    return c == '\n' || c == '\r' || c == '\0';
+}
+
+// Finds the next line ending or NUL byte
+const char *findSpecial(const char *p, const char *end)
+{
+#ifdef NN_SIMD_SSE2
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i nul = _mm_setzero_si128();
+
+    while (end - p >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, lf), _mm_cmpeq_epi8(block, cr)), _mm_cmpeq_epi8(block, nul));
+        const int mask = _mm_movemask_epi8(matches);
+
+        if (mask != 0) {
+            return p + qCountTrailingZeroBits(static_cast<quint32>(mask));
+        }
+
+        p += 16;
+    }
+#endif
+
+    while (p < end && !isSpecial(*p)) {
+        ++p;
+    }
+
+    return p;
+}
+
+}
+
+void LoadAnalyzer::addData(const char *data, qint64 length)
+{
+    const char *p = data;
+    const char *end = data + length;
+
+    while (p < end) {
+        if (measuringIndent) {
+            while (p < end && (*p == ' ' || *p == '\t')) {
+                if (*p == '\t' && leadingSpaces == 0) {
+                    indentStartsWithTab = true;
+                }
+                else if (*p == ' ' && !indentStartsWithTab) {
+                    ++leadingSpaces;
+                }
+
+                lastWasCR = false;
+                ++currentLineLength;
+                ++p;
+            }
+
+            if (p == end) {
+                break;
+            }
+
+            // Blank lines don't say anything about the indentation
+            if (*p != '\r' && *p != '\n') {
+                endIndentation();
+            }
+        }
+
+        const char *special = findSpecial(p, end);
+
+        if (special != p) {
+            lastWasCR = false;
+            currentLineLength += special - p;
+            p = special;
+        }
+
+        if (p == end) {
+            break;
+        }
+
+        const char c = *p++;
+
+        if (c == '\0') {
+            result.isBinary = true;
+            lastWasCR = false;
+            ++currentLineLength;
+        }
+        else if (c == '\r') {
+            ++result.crCount;
+            endLine();
+            lastWasCR = true;
+        }
+        else if (lastWasCR) {
+            // The line already ended at the \r, so this was really a \r\n
+            --result.crCount;
+            ++result.crlfCount;
+            lastWasCR = false;
+        }
+        else {
+            ++result.lfCount;
+            endLine();
+        }
+    }
+}
+
+FileAnalysis LoadAnalyzer::finish()
+{
+    result.longestLine = qMax(result.longestLine, currentLineLength);
+
+    const qint64 most = qMax(result.crlfCount, qMax(result.lfCount, result.crCount));
+    if (most > 0) {
+        if (most == result.crlfCount) result.eolMode = SC_EOL_CRLF;
+        else if (most == result.lfCount) result.eolMode = SC_EOL_LF;
+        else result.eolMode = SC_EOL_CR;
+
+        result.hasMixedEols = (result.crlfCount > 0) + (result.lfCount > 0) + (result.crCount > 0) > 1;
+    }
+
+    if (tabIndentedLines > spaceIndentedLines) {
+        result.useTabs = 1;
+    }
+    else if (spaceIndentedLines > tabIndentedLines) {
+        result.useTabs = 0;
+
+        // Use the most common change in indentation between lines
+        int best = 0;
+        for (int i = 1; i < 9; ++i) {
+            if (indentDeltas[i] > indentDeltas[best]) {
+                best = i;
+            }
+        }
+        result.indentSize = best;
+    }
+
+    result.isValid = true;
+
+    return result;
+}
+
+void LoadAnalyzer::endLine()
+{
+    result.longestLine = qMax(result.longestLine, currentLineLength);
+    currentLineLength = 0;
+
+    measuringIndent = true;
+    indentStartsWithTab = false;
+    leadingSpaces = 0;
+}
+
+void LoadAnalyzer::endIndentation()
+{
+    measuringIndent = false;
+
+    if (indentStartsWithTab) {
+        ++tabIndentedLines;
+        return;
+    }
+
+    if (leadingSpaces > 0) {
+        ++spaceIndentedLines;
+    }
+
+    const int delta = qAbs(leadingSpaces - previousSpaceIndent);
+    if (delta > 0 && delta < 9) {
+        ++indentDeltas[delta];
+    }
+
+    previousSpaceIndent = leadingSpaces;
+}
@@ -0,0 +1,75 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LOADANALYZER_H
+#define LOADANALYZER_H
+
+#include <QtGlobal>
+
+
+struct FileAnalysis {
+    bool isValid = false;
+
+    // SC_EOL_* of the most common line ending, or -1 if there were none
+    int eolMode = -1;
+    bool hasMixedEols = false;
+    qint64 crlfCount = 0;
+    qint64 lfCount = 0;
+    qint64 crCount = 0;
+
+    // -1 if it couldn't be determined, otherwise 0 or 1
+    int useTabs = -1;
+    // Width of space based indentation, 0 if unknown
+    int indentSize = 0;
+
+    qint64 longestLine = 0;
+
+    // Any NUL bytes probably mean this isn't really a text file
+    bool isBinary = false;
+};
+
+
+// Gathers details about a file's contents as it is being loaded, so that the data only has to be
+// looked at once. Data can be given in any size of pieces.
+class LoadAnalyzer
+{
+public:
+    void addData(const char *data, qint64 length);
+    FileAnalysis finish();
+
+private:
+    void endLine();
+    void endIndentation();
+
+    FileAnalysis result;
+
+    qint64 currentLineLength = 0;
+    bool lastWasCR = false;
+
+    bool measuringIndent = true;
+    bool indentStartsWithTab = false;
+    int leadingSpaces = 0;
+    int previousSpaceIndent = 0;
+
+    qint64 tabIndentedLines = 0;
+    qint64 spaceIndentedLines = 0;
+    qint64 indentDeltas[9] = {};
+};
+
+#endif // LOADANALYZER_H
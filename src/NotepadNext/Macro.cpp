@@ -85,8 +85,8 @@ void Macro::replayTillEndOfFile(ScintillaNext *editor) const
     editor->beginUndoAction();
 
     do {
-        int length = editor->length();
-        int curPos = editor->currentPos();
+        Sci_Position length = editor->length();
+        Sci_Position curPos = editor->currentPos();
 
         replay(editor);
 
@@ -97,8 +97,8 @@ void Macro::replayTillEndOfFile(ScintillaNext *editor) const
         // The doc can grow...
         else if(editor->length() > length) {
             // are we going to catch up?
-            int deltaLength = editor->length() - length;
-            int deltaPos = editor->currentPos() - curPos;
+            Sci_Position deltaLength = editor->length() - length;
+            Sci_Position deltaPos = editor->currentPos() - curPos;
             if (deltaPos > deltaLength) {
                 // Cursor position is moving forward more than document is growing
                 continue;
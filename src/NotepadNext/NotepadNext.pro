@@ -15,7 +15,7 @@
 # along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
 
 
-QT += core widgets printsupport network
+QT += core widgets printsupport network concurrent
 
 TARGET = NotepadNext
 
@@ -70,7 +70,14 @@ SOURCES += \
     EditorHexViewerTableModel.cpp \
     EditorManager.cpp \
     EditorPrintPreviewRenderer.cpp \
+    EncodingWriter.cpp \
+    FileChangeMonitor.cpp \
     FileDialogHelpers.cpp \
+    FileLineIndex.cpp \
+    FileLoader.cpp \
+    FileReader.cpp \
+    FileReloader.cpp \
+    FileSaver.cpp \
     Finder.cpp \
     HtmlConverter.cpp \
     IFaceTable.cpp \
@@ -78,6 +85,9 @@ SOURCES += \
     LanguageKeywordsModel.cpp \
     LanguagePropertiesModel.cpp \
     LanguageStylesModel.cpp \
+    LargeFileProfile.cpp \
+    LiteralSearch.cpp \
+    LoadAnalyzer.cpp \
     LuaExtension.cpp \
     LuaState.cpp \
     Macro.cpp \
@@ -88,11 +98,15 @@ SOURCES += \
     MacroStepTableModel.cpp \
     NotepadNextApplication.cpp \
     NppImporter.cpp \
+    PagedFileView.cpp \
+    ParallelFinder.cpp \
     QRegexSearch.cpp \
     QuickFindWidget.cpp \
     RangeAllocator.cpp \
     RecentFilesListManager.cpp \
     RecentFilesListMenuBuilder.cpp \
+    RecoveryJournal.cpp \
+    RecoveryManager.cpp \
     RtfConverter.cpp \
     SciIFaceTable.cpp \
     ScintillaCommenter.cpp \
@@ -102,7 +116,10 @@ SOURCES += \
     SessionManager.cpp \
     Settings.cpp \
     SpinBoxDelegate.cpp \
+    TextDiff.cpp \
     UndoAction.cpp \
+    Utf8Transcoder.cpp \
+    Utf8Validator.cpp \
     ZoomEventWatcher.cpp \
     decorators/ApplicationDecorator.cpp \
     decorators/AutoCompletion.cpp \
@@ -134,6 +151,7 @@ SOURCES += \
     decorators/LineNumbers.cpp \
     decorators/SmartHighlighter.cpp \
     widgets/EditorInfoStatusBar.cpp \
+    widgets/FileLoadingBar.cpp \
     widgets/StatusLabel.cpp
 
 HEADERS += \
@@ -146,7 +164,14 @@ HEADERS += \
     EditorHexViewerTableModel.h \
     EditorManager.h \
     EditorPrintPreviewRenderer.h \
+    EncodingWriter.h \
+    FileChangeMonitor.h \
     FileDialogHelpers.h \
+    FileLineIndex.h \
+    FileLoader.h \
+    FileReader.h \
+    FileReloader.h \
+    FileSaver.h \
     Finder.h \
     FocusWatcher.h \
     HtmlConverter.h \
@@ -156,6 +181,9 @@ HEADERS += \
     LanguageKeywordsModel.h \
     LanguagePropertiesModel.h \
     LanguageStylesModel.h \
+    LargeFileProfile.h \
+    LiteralSearch.h \
+    LoadAnalyzer.h \
     LuaExtension.h \
     LuaState.h \
     Macro.h \
@@ -166,11 +194,15 @@ HEADERS += \
     MacroStepTableModel.h \
     NotepadNextApplication.h \
     NppImporter.h \
+    PagedFileView.h \
+    ParallelFinder.h \
     QRegexSearch.h \
     QuickFindWidget.h \
     RangeAllocator.h \
     RecentFilesListManager.h \
     RecentFilesListMenuBuilder.h \
+    RecoveryJournal.h \
+    RecoveryManager.h \
     RtfConverter.h \
     SciIFaceTable.h \
     ScintillaCommenter.h \
@@ -180,8 +212,12 @@ HEADERS += \
     SelectionTracker.h \
     SessionManager.h \
     Settings.h \
+    SimdHelpers.h \
     SpinBoxDelegate.h \
+    TextDiff.h \
     UndoAction.h \
+    Utf8Transcoder.h \
+    Utf8Validator.h \
     ZoomEventWatcher.h \
     decorators/ApplicationDecorator.h \
     decorators/AutoCompletion.h \
@@ -212,6 +248,7 @@ HEADERS += \
     decorators/SmartHighlighter.h \
     docks/SearchResultsDock.h \
     widgets/EditorInfoStatusBar.h \
+    widgets/FileLoadingBar.h \
     widgets/StatusLabel.h
 
 FORMS += \
@@ -236,6 +273,13 @@ RESOURCES += \
     resources.qrc \
     scripts.qrc
 
+pcre2 {
+    include(../pcre2.pri)
+
+    SOURCES += Pcre2RegexSearch.cpp
+    HEADERS += Pcre2RegexSearch.h
+}
+
 INCLUDEPATH += $$PWD/decorators
 INCLUDEPATH += $$PWD/dialogs
 INCLUDEPATH += $$PWD/docks
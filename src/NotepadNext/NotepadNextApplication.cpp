@@ -24,6 +24,9 @@
 #include "LuaExtension.h"
 #include "DebugManager.h"
 #include "SessionManager.h"
+#include "FileChangeMonitor.h"
+#include "LargeFileProfile.h"
+#include "RecoveryManager.h"
 
 #include "LuaState.h"
 #include "lua.hpp"
@@ -35,6 +38,7 @@
 #include "Lexilla.h"
 
 #include <QCommandLineParser>
+#include <QMessageBox>
 #include <QSettings>
 
 #ifdef Q_OS_WIN
@@ -107,8 +111,10 @@ bool NotepadNextApplication::init()
     luaState = new LuaState();
 
     recentFilesListManager = new RecentFilesListManager(this);
-    editorManager = new EditorManager(this);
     settings = new Settings(this);
+    editorManager = new EditorManager(this);
+    fileChangeMonitor = new FileChangeMonitor(editorManager, this);
+    recoveryManager = new RecoveryManager(editorManager, this);
     sessionManager = new SessionManager();
 
     connect(editorManager, &EditorManager::editorCreated, recentFilesListManager, [=](ScintillaNext *editor) {
@@ -208,10 +214,19 @@ bool NotepadNextApplication::init()
         }
     });
 
+    // Anything left behind by a crash is newer than the session, so it goes first and the session skips those files
+    if (recoveryManager->recover() > 0) {
+        qInfo("Recovered unsaved changes from the last run");
+    }
+
     if (settings->restorePreviousSession()) {
         qInfo("Restoring previous session");
 
         sessionManager->loadSession(windows.first(), editorManager);
+
+        if (settings->prefetchSessionFiles()) {
+            editorManager->prefetchDeferredEditors();
+        }
     }
 
     openFiles(parser.positionalArguments());
@@ -227,6 +242,12 @@ bool NotepadNextApplication::init()
     windows.first()->restoreWindowState();
     windows.first()->show();
 
+    if (!recoveryManager->unrecoveredBuffers().isEmpty()) {
+        QMessageBox::warning(windows.first(), tr("Unable to Recover Changes"),
+                             tr("Unsaved changes from the last run could not be recovered because these files have changed on disk since:<br><br>%1<br><br>The recovery data has been kept in <b>%2</b>.")
+                                 .arg(recoveryManager->unrecoveredBuffers().join(QStringLiteral("<br>")), QDir::toNativeSeparators(recoveryManager->unrecoveredDirectory().absolutePath())));
+    }
+
     DebugManager::resumeDebugOutput();
 
     return true;
@@ -270,6 +291,21 @@ QStringList NotepadNextApplication::getLanguages() const
                 )");
 }
 
+bool NotepadNextApplication::languageNeedsStyles(ScintillaNext *editor, const QString &languageName) const
+{
+    if (!(editor->documentOptions() & SC_DOCUMENTOPTION_STYLES_NONE) || LargeFileProfile::isFeatureDisabled(editor, LargeFileProfile::SyntaxHighlighting)) {
+        return false;
+    }
+
+    return languageHasLexer(languageName);
+}
+
+bool NotepadNextApplication::languageHasLexer(const QString &languageName) const
+{
+    getLuaState()->execute(QString("languageName = \"%1\"").arg(languageName).toLatin1().constData());
+    return getLuaState()->executeAndReturn<QString>("return languages[languageName].lexer") != QStringLiteral("null");
+}
+
 void NotepadNextApplication::setEditorLanguage(ScintillaNext *editor, const QString &languageName) const
 {
     LuaExtension::Instance().setEditor(editor);
@@ -280,7 +316,16 @@ void NotepadNextApplication::setEditorLanguage(ScintillaNext *editor, const QStr
     editor->languageName = languageName;
     editor->languageSingleLineComment = getLuaState()->executeAndReturn<QString>("return languages[languageName].singleLineComment or \"\"").toUtf8();
 
-    auto lexerInstance = CreateLexer(lexer.toLatin1().constData());
+    // Large files get a plain lexer unless highlighting has been turned back on
+    const bool highlighting = !LargeFileProfile::isFeatureDisabled(editor, LargeFileProfile::SyntaxHighlighting);
+    const bool folding = highlighting && !LargeFileProfile::isFeatureDisabled(editor, LargeFileProfile::CodeFolding);
+
+    // Plain text files are loaded without styles, which have to be added back to use a real lexer
+    if (highlighting && lexer != QStringLiteral("null") && (editor->documentOptions() & SC_DOCUMENTOPTION_STYLES_NONE)) {
+        editor->setDocumentOptions(editor->documentOptions() & ~SC_DOCUMENTOPTION_STYLES_NONE);
+    }
+
+    auto lexerInstance = CreateLexer(highlighting ? lexer.toLatin1().constData() : "null");
     editor->setILexer((sptr_t) lexerInstance);
     editor->clearDocumentStyle(); // Remove all previous style information, setting the lexer does not guarantee styling information is cleared
 
@@ -291,6 +336,7 @@ void NotepadNextApplication::setEditorLanguage(ScintillaNext *editor, const QStr
     // property doesn't currently matter, but may be used at a later point.
     getLuaState()->execute(QString("skip_tabs = %1").arg(editor->QObject::property("nn_skip_usetabs").isValid() ? "true" : "false").toLatin1().constData());
     getLuaState()->execute(QString("skip_tabwidth = %1").arg(editor->QObject::property("nn_skip_tabwidth").isValid() ? "true" : "false").toLatin1().constData());
+    getLuaState()->execute(QString("allow_folding = %1").arg(folding ? "true" : "false").toLatin1().constData());
 
     getLuaState()->execute(R"(
         local L = languages[languageName]
@@ -302,7 +348,7 @@ void NotepadNextApplication::setEditorLanguage(ScintillaNext *editor, const QStr
             editor.TabWidth = L.tabSize or 4
         end
 
-        editor.MarginWidthN[2] = L.disableFoldMargin and 0 or 16
+        editor.MarginWidthN[2] = (L.disableFoldMargin or not allow_folding) and 0 or 16
         if L.styles then
             for name, style in pairs(L.styles) do
                 editor.StyleFore[style.id] = style.fgColor
@@ -327,7 +373,7 @@ void NotepadNextApplication::setEditorLanguage(ScintillaNext *editor, const QStr
             end
         end
 
-        editor.Property["fold"] = "1"
+        editor.Property["fold"] = allow_folding and "1" or "0"
         editor.Property["fold.compact"] = "0"
     )");
 }
@@ -456,6 +502,10 @@ void NotepadNextApplication::loadSettings()
     settings->setRestorePreviousSession(qsettings.value("App/RestorePreviousSession", false).toBool());
     settings->setRestoreUnsavedFiles(qsettings.value("App/RestoreUnsavedFiles", false).toBool());
     settings->setRestoreTempFiles(qsettings.value("App/RestoreTempFiles", false).toBool());
+    settings->setPrefetchSessionFiles(qsettings.value("App/PrefetchSessionFiles", false).toBool());
+    settings->setLargeFileSize(qsettings.value("App/LargeFileSize", settings->largeFileSize()).toInt());
+    settings->setLargeFileLineLength(qsettings.value("App/LargeFileLineLength", settings->largeFileLineLength()).toInt());
+    settings->setPagedFileSize(qsettings.value("App/PagedFileSize", settings->pagedFileSize()).toInt());
     recentFilesListManager->setFileList(qsettings.value("App/RecentFilesList").toStringList());
 }
 
@@ -466,6 +516,10 @@ void NotepadNextApplication::saveSettings()
     qsettings.setValue("App/RestorePreviousSession", settings->restorePreviousSession());
     qsettings.setValue("App/RestoreUnsavedFiles", settings->restoreUnsavedFiles());
     qsettings.setValue("App/RestoreTempFiles", settings->restoreTempFiles());
+    qsettings.setValue("App/PrefetchSessionFiles", settings->prefetchSessionFiles());
+    qsettings.setValue("App/LargeFileSize", settings->largeFileSize());
+    qsettings.setValue("App/LargeFileLineLength", settings->largeFileLineLength());
+    qsettings.setValue("App/PagedFileSize", settings->pagedFileSize());
     qsettings.setValue("App/RecentFilesList", recentFilesListManager->fileList());
 }
 
@@ -489,6 +543,9 @@ MainWindow *NotepadNextApplication::createNewWindow()
         }
 
         getSessionManager()->saveSession(w);
+
+        // Shutting down cleanly, so there is nothing to recover next time
+        recoveryManager->clear();
     });
 
     return w;
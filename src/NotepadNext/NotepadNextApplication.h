@@ -32,7 +32,9 @@
 class MainWindow;
 class LuaState;
 class EditorManager;
+class FileChangeMonitor;
 class RecentFilesListManager;
+class RecoveryManager;
 class ScintillaNext;
 class SessionManager;
 
@@ -47,6 +49,7 @@ public:
 
     RecentFilesListManager *getRecentFilesListManager() const { return recentFilesListManager; }
     EditorManager *getEditorManager() const { return editorManager; }
+    FileChangeMonitor *getFileChangeMonitor() const { return fileChangeMonitor; }
     SessionManager *getSessionManager() const;
 
     LuaState *getLuaState() const { return luaState; }
@@ -56,6 +59,10 @@ public:
     QStringList getLanguages() const;
     void setEditorLanguage(ScintillaNext *editor, const QString &languageName) const;
 
+    // True if setting the language has to move the text into a new document with room for styles
+    bool languageNeedsStyles(ScintillaNext *editor, const QString &languageName) const;
+    bool languageHasLexer(const QString &languageName) const;
+
     QString detectLanguage(ScintillaNext *editor) const;
     QString detectLanguageFromExtension(const QString &extension) const;
     QString detectLanguageFromContents(ScintillaNext *editor) const;
@@ -77,7 +84,9 @@ private:
     void loadSettings();
 
     EditorManager *editorManager;
+    FileChangeMonitor *fileChangeMonitor;
     RecentFilesListManager *recentFilesListManager;
+    RecoveryManager *recoveryManager;
     Settings *settings;
     SessionManager *sessionManager;
 
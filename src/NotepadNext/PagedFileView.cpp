@@ -0,0 +1,414 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "PagedFileView.h"
+#include "FileLoadingBar.h"
+#include "LiteralSearch.h"
+#include "ScintillaNext.h"
+
+#include <QFileInfo>
+#include <QTimer>
+#include <QtConcurrent>
+
+
+const qint64 WINDOW_LINES = 20000;
+const qint64 PAGE_MARGIN = 1000;
+const qint64 MAX_WINDOW_SIZE = 1024 * 1024 * 16;
+const qint64 SEARCH_CHUNK_SIZE = 1024 * 1024 * 4;
+
+
+ScintillaNext *PagedFileView::openFile(const QString &filePath)
+{
+    qInfo(Q_FUNC_INFO);
+
+    // Make sure the file can actually be read before creating anything
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning("QFile::open() failed when opening \"%s\" - error code %d: %s", qUtf8Printable(file.fileName()), file.error(), qUtf8Printable(file.errorString()));
+        return Q_NULLPTR;
+    }
+    file.close();
+
+    ScintillaNext *editor = new ScintillaNext(file.fileName());
+    editor->setFileInfo(filePath);
+
+    new PagedFileView(editor, filePath);
+
+    return editor;
+}
+
+PagedFileView *PagedFileView::forEditor(const ScintillaNext *editor)
+{
+    return editor->findChild<PagedFileView *>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+PagedFileView::PagedFileView(ScintillaNext *editor, const QString &filePath) :
+    QObject(editor),
+    editor(editor),
+    filePath(filePath),
+    file(filePath)
+{
+    file.open(QIODevice::ReadOnly);
+
+    editor->setReadOnly(true);
+    editor->setUndoCollection(false);
+
+    // The line numbers are for the whole file, not just what is in the editor
+    editor->setMarginTypeN(0, SC_MARGIN_RTEXT);
+
+    connect(&indexWatcher, &QFutureWatcher<bool>::finished, this, &PagedFileView::indexFinished);
+    connect(&searchWatcher, &QFutureWatcher<SearchResult>::finished, this, &PagedFileView::searchDone);
+    connect(editor, &ScintillaNext::updateUi, this, [=](Scintilla::Update updated) {
+        if (Scintilla::FlagSet(updated, Scintilla::Update::VScroll)) {
+            viewScrolled();
+        }
+    });
+
+    startIndexing();
+}
+
+PagedFileView::~PagedFileView()
+{
+    // The workers reference members of this object so they have to be stopped before anything is destroyed
+    canceled = true;
+    indexWatcher.waitForFinished();
+    searchWatcher.waitForFinished();
+}
+
+qint64 PagedFileView::currentLine() const
+{
+    return fileLine(editor->lineFromPosition(editor->currentPos()));
+}
+
+void PagedFileView::showLine(qint64 line)
+{
+    if (!indexed) {
+        return;
+    }
+
+    line = qBound<qint64>(0, line, index.lineCount() - 1);
+
+    if (line < firstLine || line >= firstLine + windowLineCount) {
+        loadWindow(line);
+    }
+
+    editor->ensureVisible(line - firstLine);
+    editor->gotoLine(line - firstLine);
+    editor->verticalCentreCaret();
+}
+
+void PagedFileView::showRange(qint64 offset, qint64 length)
+{
+    if (!indexed) {
+        return;
+    }
+
+    if (offset < firstOffset || offset + length > firstOffset + editor->length()) {
+        loadWindow(index.lineOfOffset(file, offset));
+    }
+
+    const Sci_Position start = qBound<Sci_Position>(0, offset - firstOffset, editor->length());
+    const Sci_Position end = qBound<Sci_Position>(start, offset + length - firstOffset, editor->length());
+
+    editor->goToRange({start, end});
+}
+
+void PagedFileView::findNext(const QByteArray &text, int flags, bool wrap, bool forward)
+{
+    qInfo(Q_FUNC_INFO);
+
+    if (!indexed || isSearching() || text.isEmpty()) {
+        return;
+    }
+
+    canceled = false;
+
+    const QString path = filePath;
+    const bool matchCase = flags & SCFIND_MATCHCASE;
+    const qint64 size = index.fileSize();
+    const qint64 from = firstOffset + (forward ? editor->selectionEnd() : editor->selectionStart());
+
+    searchWatcher.setFuture(QtConcurrent::run([=]() {
+        SearchResult result = forward ? search(path, text, matchCase, from, size, true, canceled)
+                                      : search(path, text, matchCase, 0, from, false, canceled);
+
+        if (result.offset == -1 && wrap) {
+            result = forward ? search(path, text, matchCase, 0, qMin(from + text.size() - 1, size), true, canceled)
+                             : search(path, text, matchCase, qMax<qint64>(0, from - text.size() + 1), size, false, canceled);
+            result.wrapped = result.offset != -1;
+        }
+
+        return result;
+    }));
+}
+
+void PagedFileView::reload()
+{
+    qInfo(Q_FUNC_INFO);
+
+    if (indexWatcher.isRunning()) {
+        return;
+    }
+
+    startIndexing();
+}
+
+void PagedFileView::startIndexing()
+{
+    canceled = false;
+    bytesIndexed = 0;
+
+    const QString path = filePath;
+    const qint64 size = qMax<qint64>(QFileInfo(filePath).size(), 1);
+
+    FileLoadingBar *loadingBar = new FileLoadingBar(editor);
+    QTimer *progressTimer = new QTimer(loadingBar);
+    connect(progressTimer, &QTimer::timeout, loadingBar, [=]() {
+        loadingBar->setProgress(static_cast<int>(bytesIndexed * 100 / size));
+    });
+    connect(loadingBar, &FileLoadingBar::cancelRequested, this, [=]() { canceled = true; });
+    connect(&indexWatcher, &QFutureWatcher<bool>::finished, loadingBar, &FileLoadingBar::deleteLater);
+
+    indexWatcher.setFuture(QtConcurrent::run([=]() {
+        return pendingIndex.build(path, &canceled, &bytesIndexed);
+    }));
+
+    progressTimer->start(100);
+    loadingBar->show();
+}
+
+void PagedFileView::indexFinished()
+{
+    qInfo(Q_FUNC_INFO);
+
+    if (!indexWatcher.result() || canceled) {
+        // There is nothing to show the user if it never got indexed
+        if (!indexed) {
+            qWarning("Failed to index \"%s\"", qUtf8Printable(filePath));
+            editor->close();
+            emit editor->loadFinished(false);
+        }
+
+        return;
+    }
+
+    const bool firstTime = !indexed;
+    const qint64 topLine = firstTime ? 0 : fileLine(editor->docLineFromVisible(editor->firstVisibleLine()));
+    const qint64 caretLine = firstTime ? 0 : currentLine();
+
+    index = pendingIndex;
+    indexed = true;
+
+    // The file may have been replaced, e.g. a rotated log
+    file.close();
+    file.open(QIODevice::ReadOnly);
+
+    qInfo("Indexed %lld lines of \"%s\"", index.lineCount(), qUtf8Printable(filePath));
+
+    if (editor->isFollowing()) {
+        showLine(index.lineCount() - 1);
+    }
+    else {
+        loadWindow(topLine);
+        editor->setFirstVisibleLine(topLine - firstLine);
+
+        if (caretLine >= firstLine && caretLine < firstLine + windowLineCount) {
+            editor->setEmptySelection(editor->positionFromLine(caretLine - firstLine));
+        }
+    }
+
+    if (firstTime) {
+        emit editor->loadFinished(true);
+    }
+}
+
+void PagedFileView::searchDone()
+{
+    const SearchResult result = searchWatcher.result();
+
+    if (result.offset != -1) {
+        showRange(result.offset, result.length);
+    }
+
+    emit searchFinished(result.offset != -1, result.wrapped);
+}
+
+void PagedFileView::viewScrolled()
+{
+    if (loadingWindow || !indexed) {
+        return;
+    }
+
+    const qint64 top = editor->docLineFromVisible(editor->firstVisibleLine());
+    const qint64 bottom = top + editor->linesOnScreen();
+
+    const bool nearTop = top < PAGE_MARGIN && firstLine > 0;
+    const bool nearBottom = bottom > windowLineCount - PAGE_MARGIN && firstLine + windowLineCount < index.lineCount();
+
+    if (!nearTop && !nearBottom) {
+        return;
+    }
+
+    // Move the window so the top line stays exactly where it is on screen
+    const qint64 topLine = fileLine(top);
+    const qint64 caretLine = currentLine();
+    const sptr_t caretColumn = editor->currentPos() - editor->positionFromLine(editor->lineFromPosition(editor->currentPos()));
+
+    loadWindow(topLine);
+    editor->setFirstVisibleLine(topLine - firstLine);
+
+    if (caretLine >= firstLine && caretLine < firstLine + windowLineCount) {
+        const sptr_t line = caretLine - firstLine;
+        editor->setEmptySelection(qMin(editor->positionFromLine(line) + caretColumn, editor->lineEndPosition(line)));
+    }
+}
+
+void PagedFileView::loadWindow(qint64 line)
+{
+    const qint64 totalLines = index.lineCount();
+    const qint64 first = qBound<qint64>(0, line - WINDOW_LINES / 2, qMax<qint64>(0, totalLines - WINDOW_LINES));
+    const qint64 last = qMin(first + WINDOW_LINES, totalLines);
+
+    const qint64 start = index.offsetOfLine(file, first);
+    qint64 end = last >= totalLines ? index.fileSize() : index.offsetOfLine(file, last);
+
+    // Really long lines could still be too much to hold, so just cut it off
+    if (end - start > MAX_WINDOW_SIZE) {
+        qWarning("Lines %lld to %lld are too long, only showing the first %lld bytes", first, last, MAX_WINDOW_SIZE);
+        end = start + MAX_WINDOW_SIZE;
+    }
+
+    file.seek(start);
+    QByteArray data = file.read(end - start);
+
+    // The line ending belongs to the last line, not the start of an empty one
+    if (end < index.fileSize() && data.endsWith('\n')) {
+        data.chop(data.endsWith("\r\n") ? 2 : 1);
+    }
+
+    qDebug("Showing lines %lld to %lld (%lld bytes)", first, last, end - start);
+
+    loadingWindow = true;
+
+    editor->setReadOnly(false);
+    editor->clearAll();
+    editor->appendText(data.size(), data.constData());
+    editor->setReadOnly(true);
+    editor->setSavePointIncludingDocumentSwap();
+
+    firstLine = first;
+    firstOffset = start;
+    windowLineCount = editor->lineCount();
+
+    updateLineNumbers();
+
+    loadingWindow = false;
+}
+
+void PagedFileView::updateLineNumbers()
+{
+    const int digits = QByteArray::number(index.lineCount()).size();
+    editor->setMarginWidthN(0, 8 + qMax(digits, 3) * editor->textWidth(STYLE_LINENUMBER, "8"));
+
+    for (qint64 i = 0; i < windowLineCount; ++i) {
+        editor->marginSetText(i, QByteArray::number(firstLine + i + 1).constData());
+        editor->marginSetStyle(i, STYLE_LINENUMBER);
+    }
+}
+
+PagedFileView::SearchResult PagedFileView::search(const QString &filePath, const QByteArray &text, bool matchCase, qint64 from, qint64 to, bool forward, const std::atomic_bool &canceled)
+{
+    SearchResult result{-1, text.size(), false};
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return result;
+    }
+
+    // Case folding has to understand UTF-8, a match can also be a different number of bytes than the text
+    const LiteralSearch::FoldedSearch foldedSearch = matchCase ? LiteralSearch::FoldedSearch() : LiteralSearch::FoldedSearch(text);
+
+    if (!matchCase && !foldedSearch.isValid()) {
+        return result;
+    }
+
+    // Chunks overlap a little so matches spanning two of them are not missed
+    const qint64 overlap = (matchCase ? text.size() : foldedSearch.maximumMatchLength()) - 1;
+
+    qint64 start = forward ? from : qMax(from, to - SEARCH_CHUNK_SIZE);
+    qint64 end = forward ? qMin(to, from + SEARCH_CHUNK_SIZE) : to;
+
+    while (start < end && !canceled) {
+        file.seek(start);
+        const QByteArray chunk = file.read(end - start);
+
+        if (chunk.isEmpty()) {
+            break;
+        }
+
+        qint64 i = -1;
+        qint64 matchLength = text.size();
+
+        if (matchCase) {
+            i = forward ? LiteralSearch::indexOf(chunk.constData(), chunk.size(), text.constData(), text.size()) : chunk.lastIndexOf(text);
+        }
+        else {
+            // There is no backwards folded search, so keep going forwards to find the last match in the chunk
+            qint64 pos = 0;
+            qint64 length = 0;
+            qint64 found;
+
+            while (pos < chunk.size() && (found = foldedSearch.indexIn(chunk.constData() + pos, chunk.size() - pos, &length)) != -1) {
+                i = pos + found;
+                matchLength = length;
+
+                if (forward) {
+                    break;
+                }
+
+                pos = i + 1;
+            }
+        }
+
+        if (i != -1) {
+            result.offset = start + i;
+            result.length = matchLength;
+            return result;
+        }
+
+        if (forward) {
+            if (end == to) {
+                break;
+            }
+
+            start = end - overlap;
+            end = qMin(to, start + SEARCH_CHUNK_SIZE);
+        }
+        else {
+            if (start == from) {
+                break;
+            }
+
+            end = start + overlap;
+            start = qMax(from, end - SEARCH_CHUNK_SIZE);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,111 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PAGEDFILEVIEW_H
+#define PAGEDFILEVIEW_H
+
+#include "FileLineIndex.h"
+
+#include <QFile>
+#include <QFutureWatcher>
+#include <QObject>
+
+#include <atomic>
+
+
+class ScintillaNext;
+
+// Shows a file that is too big to hold in memory. Only a window of lines around the viewport is kept in
+// the editor, which is read-only, and it gets moved as the user scrolls. Everything else (line numbers,
+// going to a line, searching) is translated to positions in the file on disk.
+class PagedFileView : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct SearchResult {
+        qint64 offset;
+        qint64 length;
+        bool wrapped;
+    };
+
+    // Creates an editor for the file, it still needs to be managed
+    static ScintillaNext *openFile(const QString &filePath);
+
+    // Null if the editor is not paged
+    static PagedFileView *forEditor(const ScintillaNext *editor);
+
+    explicit PagedFileView(ScintillaNext *editor, const QString &filePath);
+    ~PagedFileView() override;
+
+    bool isIndexed() const { return indexed; }
+    qint64 lineCount() const { return index.lineCount(); }
+    qint64 fileSize() const { return index.fileSize(); }
+
+    // Converts a line in the editor to a line in the file
+    qint64 fileLine(int editorLine) const { return firstLine + editorLine; }
+    qint64 currentLine() const;
+
+    void showLine(qint64 line);
+    void showRange(qint64 offset, qint64 length);
+
+    // Only plain text searches are supported, SCFIND_MATCHCASE is the only flag used
+    void findNext(const QByteArray &text, int flags, bool wrap, bool forward = true);
+    bool isSearching() const { return searchWatcher.isRunning(); }
+
+public slots:
+    // Re-indexes the file and reloads the lines being viewed
+    void reload();
+
+signals:
+    void searchFinished(bool found, bool wrapped);
+
+private slots:
+    void indexFinished();
+    void searchDone();
+    void viewScrolled();
+
+private:
+    void startIndexing();
+    void loadWindow(qint64 line);
+    void updateLineNumbers();
+
+    static SearchResult search(const QString &filePath, const QByteArray &text, bool matchCase, qint64 from, qint64 to, bool forward, const std::atomic_bool &canceled);
+
+    ScintillaNext *editor;
+    QString filePath;
+    QFile file;
+
+    FileLineIndex index;
+    FileLineIndex pendingIndex;
+    bool indexed = false;
+    QFutureWatcher<bool> indexWatcher;
+    std::atomic<qint64> bytesIndexed{0};
+
+    // The window of lines currently in the editor
+    qint64 firstLine = 0;
+    qint64 firstOffset = 0;
+    qint64 windowLineCount = 0;
+    bool loadingWindow = false;
+
+    QFutureWatcher<SearchResult> searchWatcher;
+    std::atomic_bool canceled{false};
+};
+
+#endif // PAGEDFILEVIEW_H
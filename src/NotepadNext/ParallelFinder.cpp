@@ -0,0 +1,375 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "ParallelFinder.h"
+#include "FileReader.h"
+#include "ScintillaNext.h"
+
+// Only for the Scintilla internals needed to search a detached document
+#include "QRegexSearch.h"
+
+#include <QFile>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+
+using namespace Scintilla;
+
+static void releaseDocument(Document *&document)
+{
+    if (document) {
+        document->Release();
+        document = Q_NULLPTR;
+    }
+}
+
+ParallelFinder::ParallelFinder(const QString &text, int flags, QObject *parent) :
+    QObject(parent),
+    text(text.toUtf8()),
+    flags(flags),
+    maxFilesInFlight(qMax(1, QThreadPool::globalInstance()->maxThreadCount()))
+{
+    // Built once here since every document is searched for the same text
+    if (!(flags & (SCFIND_MATCHCASE | SCFIND_REGEXP)) && !this->text.isEmpty()) {
+        foldedSearch = LiteralSearch::FoldedSearch(this->text);
+    }
+}
+
+ParallelFinder::~ParallelFinder()
+{
+    // The workers reference this object and the documents, so they have to be stopped first
+    canceled = true;
+
+    for (File &file : files) {
+        if (file.watcher) {
+            file.watcher->waitForFinished();
+        }
+
+        releaseDocument(file.document);
+    }
+}
+
+void ParallelFinder::addDocument(ScintillaNext *editor)
+{
+    Q_ASSERT(!running);
+
+    File file;
+    file.editor = editor;
+    files.append(file);
+}
+
+void ParallelFinder::start()
+{
+    qInfo(Q_FUNC_INFO);
+
+    running = true;
+
+    startFiles();
+}
+
+void ParallelFinder::startFiles()
+{
+    // Copies are only made as threads become free, so there are never more of them than the pool can search
+    while (running && filesInFlight < maxFilesInFlight && nextFileToStart < files.size()) {
+        startFile(nextFileToStart++);
+    }
+
+    // Some files may have been searched right away
+    reportFinishedFiles();
+}
+
+void ParallelFinder::startFile(int i)
+{
+    File &file = files[i];
+    ScintillaNext *editor = file.editor;
+
+    // The editor may have been closed before its turn came
+    if (editor == Q_NULLPTR) {
+        file.done = true;
+        return;
+    }
+
+    const sptr_t page = editor->codePage();
+
+    // A detached document only has the editor's case folding for UTF-8, and only knows about the default line
+    // ends since it has no lexer. Anything else is searched right here instead.
+    const bool searchesEditor = (page != SC_CP_UTF8 && !(flags & (SCFIND_MATCHCASE | SCFIND_REGEXP))) || editor->lineEndTypesActive() != SC_LINE_END_TYPE_DEFAULT;
+
+    // Waiting for the text here would block the GUI thread, so come back once it is there
+    if (editor->isLoading() && (searchesEditor || !editor->isLoadDeferred())) {
+        startFileWhenLoaded(i);
+        return;
+    }
+
+    if (searchesEditor) {
+        file.matches = searchInEditor(editor);
+        file.done = true;
+        return;
+    }
+
+    Document *document = Q_NULLPTR;
+    QString filePath;
+
+    if (editor->isLoadDeferred()) {
+        // Placeholder tabs are read by the worker rather than loading them into the editor first
+        filePath = editor->getDeferredFilePath();
+        document = createDocument(editor, editor->getDeferredDocumentOptions());
+    }
+    else {
+        const sptr_t length = editor->length();
+        const sptr_t gap = qBound<sptr_t>(0, editor->gapPosition(), length);
+
+        document = createDocument(editor, editor->documentOptions());
+
+        // Copy the text from either side of the gap so the editor's gap doesn't get moved
+        document->Allocate(length);
+        document->AddData(reinterpret_cast<const char *>(editor->rangePointer(0, gap)), gap);
+        document->AddData(reinterpret_cast<const char *>(editor->rangePointer(gap, length - gap)), length - gap);
+    }
+
+    file.document = document;
+    file.watcher = new QFutureWatcher<QVector<Match>>(this);
+    connect(file.watcher, &QFutureWatcherBase::finished, this, [=]() {
+        File &finishedFile = files[i];
+
+        finishedFile.matches = finishedFile.watcher->result();
+        finishedFile.done = true;
+        releaseDocument(finishedFile.document);
+        --filesInFlight;
+
+        startFiles();
+    });
+
+    ++filesInFlight;
+
+    file.watcher->setFuture(QtConcurrent::run([=]() {
+        if (!filePath.isEmpty()) {
+            QFile f(filePath);
+            FileReader reader(f);
+
+            reader.setCancelFlag(&canceled);
+
+            const bool readSuccessful = reader.read([=](const char *data, qint64 length) {
+                document->AddData(data, length);
+                return true;
+            });
+
+            if (!readSuccessful) {
+                if (!canceled) {
+                    qWarning("Unable to read \"%s\" to search it", qUtf8Printable(filePath));
+                }
+
+                return QVector<Match>();
+            }
+        }
+
+        return search(document);
+    }));
+}
+
+void ParallelFinder::startFileWhenLoaded(int i)
+{
+    ScintillaNext *editor = files[i].editor;
+
+    // It counts as in flight since placeholders are read on the same pool as the searches
+    files[i].waitingForLoad = true;
+    ++filesInFlight;
+
+    auto loaded = [=](bool success) {
+        File &file = files[i];
+
+        if (!file.waitingForLoad) {
+            return;
+        }
+
+        file.waitingForLoad = false;
+        --filesInFlight;
+
+        if (success && running) {
+            startFile(i);
+        }
+        else {
+            file.done = true;
+        }
+
+        startFiles();
+    };
+
+    connect(editor, &ScintillaNext::loadFinished, this, loaded);
+    connect(editor, &QObject::destroyed, this, [=]() { loaded(false); });
+
+    // Placeholders that haven't been started yet
+    editor->ensureLoaded();
+}
+
+Document *ParallelFinder::createDocument(ScintillaNext *editor, int documentOptions) const
+{
+    const sptr_t page = editor->codePage();
+
+    Document *document = new Document(static_cast<DocumentOption>(documentOptions));
+    document->AddRef();
+    document->SetUndoCollection(false);
+    document->SetDBCSCodePage(static_cast<int>(page));
+
+    // Whole word searches need the same idea of what a word is as the editor
+    document->SetDefaultCharClasses(true);
+    document->SetCharClasses(reinterpret_cast<const unsigned char *>(editor->wordChars().constData()), CharacterClass::word);
+    document->SetCharClasses(reinterpret_cast<const unsigned char *>(editor->whitespaceChars().constData()), CharacterClass::space);
+    document->SetCharClasses(reinterpret_cast<const unsigned char *>(editor->punctuationChars().constData()), CharacterClass::punctuation);
+
+    // The case folder is created here since setting up the conversion tables is not thread safe
+    if (page == SC_CP_UTF8) {
+        document->SetCaseFolder(std::make_unique<CaseFolderUnicode>());
+    }
+
+    return document;
+}
+
+void ParallelFinder::cancel()
+{
+    if (!running) {
+        return;
+    }
+
+    qInfo(Q_FUNC_INFO);
+
+    running = false;
+    canceled = true;
+
+    emit finished(true);
+}
+
+QVector<ParallelFinder::Match> ParallelFinder::search(Document *document) const
+{
+    QVector<Match> matches;
+
+    const Sci::Position length = document->Length();
+    const bool matchCase = flags & SCFIND_MATCHCASE;
+
+    // The text was added in one go so it is all before the gap, and can be searched directly like ScintillaNext::findTextFull() does
+    const bool literal = ScintillaNext::canSearchLiterally(flags, text, document->dbcsCodePage) && (matchCase || foldedSearch.isValid());
+    const char *data = literal ? document->BufferPointer() : Q_NULLPTR;
+
+    Sci::Position pos = 0;
+    Sci::Line previousLine = -1;
+    QString lineText;
+
+    while (!canceled) {
+        Sci::Position start = -1;
+        Sci::Position matchLength = text.size();
+
+        if (literal) {
+            qint64 foundLength = text.size();
+            const qint64 found = matchCase ? LiteralSearch::indexOf(data + pos, length - pos, text.constData(), text.size())
+                                           : foldedSearch.indexIn(data + pos, length - pos, &foundLength);
+
+            if (found < 0) {
+                break;
+            }
+
+            start = pos + found;
+            matchLength = foundLength;
+
+            if ((flags & SCFIND_WHOLEWORD) && !document->IsWordAt(start, start + matchLength)) {
+                pos = start + 1;
+                continue;
+            }
+        }
+        else {
+            try {
+                start = document->FindText(pos, length, text.constData(), static_cast<FindOption>(flags), &matchLength);
+            }
+            catch (RegexError &) {
+                qWarning("Invalid regular expression: %s", text.constData());
+                break;
+            }
+
+            if (start < 0) {
+                break;
+            }
+        }
+
+        const Sci::Position end = start + matchLength;
+        const Sci::Line line = document->SciLineFromPosition(start);
+        const Sci::Position lineStart = document->LineStart(line);
+
+        // Several matches on the same line share the text
+        if (line != previousLine) {
+            const Sci::Position lineEnd = document->LineEnd(line);
+            QByteArray lineBytes(static_cast<int>(lineEnd - lineStart), Qt::Uninitialized);
+
+            document->GetCharRange(lineBytes.data(), lineStart, lineEnd - lineStart);
+            lineText = QString::fromUtf8(lineBytes);
+            previousLine = line;
+        }
+
+        matches.append({line, start - lineStart, end - lineStart, lineText});
+
+        // An empty match would just be found again at the same place
+        if (matchLength > 0) {
+            pos = end;
+        }
+        else if (end < length) {
+            pos = document->NextPosition(end, 1);
+        }
+        else {
+            break;
+        }
+    }
+
+    return matches;
+}
+
+QVector<ParallelFinder::Match> ParallelFinder::searchInEditor(ScintillaNext *editor) const
+{
+    QVector<Match> matches;
+
+    editor->setSearchFlags(flags);
+    editor->forEachMatch(text, [&](Sci_Position start, Sci_Position end) {
+        const Sci_Position line = editor->lineFromPosition(start);
+        const Sci_Position lineStart = editor->positionFromLine(line);
+        const Sci_Position lineEnd = editor->lineEndPosition(line);
+
+        matches.append({line, start - lineStart, end - lineStart, QString::fromUtf8(editor->textRangeFull(lineStart, lineEnd))});
+
+        return end;
+    });
+
+    return matches;
+}
+
+void ParallelFinder::reportFinishedFiles()
+{
+    // Files are only reported in order, so one that finished early waits for the ones before it
+    while (running && nextFile < files.size() && files[nextFile].done) {
+        File &file = files[nextFile++];
+
+        // The editor may have been closed while it was being searched
+        if (file.editor && !file.matches.isEmpty()) {
+            emit fileFinished(file.editor, file.matches);
+        }
+
+        file.matches.clear();
+    }
+
+    if (running && nextFile == files.size()) {
+        running = false;
+        emit finished(false);
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PARALLELFINDER_H
+#define PARALLELFINDER_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+
+#include <atomic>
+
+#include "Sci_Position.h"
+#include "LiteralSearch.h"
+
+
+class ScintillaNext;
+
+namespace Scintilla::Internal {
+class Document;
+}
+
+// Finds every match in several documents at once. Each document is copied into a detached Scintilla
+// document right before it is searched, and the copies are searched on the global thread pool so the
+// editors can keep changing. Only as many copies as there are threads exist at a time. Placeholder tabs
+// that haven't been read yet are read straight from disk by the worker, unless the editor has to do the search,
+// in which case it is searched once it has loaded. Files are reported in the order they were added, as soon as
+// that file and every one before it are done.
+class ParallelFinder : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Match
+    {
+        Sci_Position lineNumber;
+        Sci_Position startPositionFromBeginning;
+        Sci_Position endPositionFromBeginning;
+        QString lineText;
+    };
+
+    explicit ParallelFinder(const QString &text, int flags, QObject *parent = Q_NULLPTR);
+    ~ParallelFinder() override;
+
+    void addDocument(ScintillaNext *editor);
+    void start();
+
+    bool isRunning() const { return running; }
+
+public slots:
+    // Stops reporting results right away, any searches still running are abandoned
+    void cancel();
+
+signals:
+    // Only sent for files that have at least one match and are still open
+    void fileFinished(ScintillaNext *editor, const QVector<ParallelFinder::Match> &matches);
+    void finished(bool canceled);
+
+private:
+    struct File
+    {
+        QPointer<ScintillaNext> editor;
+        Scintilla::Internal::Document *document = Q_NULLPTR;
+        QFutureWatcher<QVector<Match>> *watcher = Q_NULLPTR;
+        QVector<Match> matches;
+        bool waitingForLoad = false;
+        bool done = false;
+    };
+
+    void startFiles();
+    void startFile(int i);
+    void startFileWhenLoaded(int i);
+    Scintilla::Internal::Document *createDocument(ScintillaNext *editor, int documentOptions) const;
+    QVector<Match> search(Scintilla::Internal::Document *document) const;
+    QVector<Match> searchInEditor(ScintillaNext *editor) const;
+    void reportFinishedFiles();
+
+    QByteArray text;
+    int flags;
+    LiteralSearch::FoldedSearch foldedSearch;
+
+    QVector<File> files;
+    int nextFile = 0;
+    int nextFileToStart = 0;
+    int filesInFlight = 0;
+    int maxFilesInFlight;
+    bool running = false;
+
+    std::atomic_bool canceled{false};
+};
+
+#endif // PARALLELFINDER_H
@@ -0,0 +1,248 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "Pcre2RegexSearch.h"
+
+#include <QtGlobal>
+
+using namespace Scintilla;
+
+
+static QByteArray errorMessage(int errorCode)
+{
+    PCRE2_UCHAR buffer[256];
+    pcre2_get_error_message(errorCode, buffer, sizeof(buffer));
+    return QByteArray(reinterpret_cast<const char *>(buffer));
+}
+
+Pcre2RegexSearch::Pcre2RegexSearch()
+{
+    // The default JIT stack is only 32K which is easy to run out of on large documents
+    matchContext = pcre2_match_context_create(Q_NULLPTR);
+    jitStack = pcre2_jit_stack_create(32 * 1024, 1024 * 1024, Q_NULLPTR);
+    pcre2_jit_stack_assign(matchContext, Q_NULLPTR, jitStack);
+}
+
+Pcre2RegexSearch::~Pcre2RegexSearch()
+{
+    releasePattern();
+
+    pcre2_jit_stack_free(jitStack);
+    pcre2_match_context_free(matchContext);
+}
+
+Sci::Position Pcre2RegexSearch::FindText(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s, bool caseSensitive, bool word, bool wordStart, Scintilla::FindOption flags, Sci::Position *length)
+{
+    Q_UNUSED(caseSensitive);
+    Q_UNUSED(word);
+    Q_UNUSED(wordStart);
+
+    // Scintilla swaps the positions when searching backwards
+    const bool forward = minPos <= maxPos;
+    Sci::Position startPos = doc->MovePositionOutsideChar(forward ? minPos : maxPos, 1, false);
+    Sci::Position endPos = doc->MovePositionOutsideChar(forward ? maxPos : minPos, -1, false);
+
+    // No need to search an empty range
+    if (startPos >= endPos)
+        return -1;
+
+    // Same behavior as QRegexSearch so the two can be compared. Invalid UTF-8 in the document never matches
+    // rather than making the whole search fail
+    uint32_t options = PCRE2_MULTILINE | PCRE2_UTF | PCRE2_UCP | PCRE2_MATCH_INVALID_UTF;
+
+    if (!FlagSet(flags, FindOption::MatchCase))
+        options |= PCRE2_CASELESS;
+
+    if (!compile(s, options))
+        return -1; // Invalid regular expression
+
+    // Start the subject at the beginning of the line so anchors and look behinds see the text before startPos
+    const Sci::Position subjectStart = doc->LineStart(doc->SciLineFromPosition(startPos));
+
+    if (matchAt(doc, subjectStart, startPos, endPos) <= 0)
+        return -1; // No match
+
+    if (!forward) {
+        // There is no way to match backwards, so keep matching forwards to find the last one in the range.
+        // The groups are only updated on success so they are left describing the last match.
+        while (true) {
+            const Sci::Position nextPos = groupEnd[0] > groupStart[0] ? groupEnd[0] : doc->NextPosition(groupStart[0], 1);
+
+            if (nextPos > endPos || matchAt(doc, subjectStart, nextPos, endPos) <= 0)
+                break;
+        }
+    }
+
+    *length = groupEnd[0] - groupStart[0];
+
+    return groupStart[0];
+}
+
+const char *Pcre2RegexSearch::SubstituteByPosition(Document *doc, const char *text, Sci::Position *length)
+{
+    qInfo(Q_FUNC_INFO);
+
+    substituted.clear();
+
+    // Same syntax as QRegexSearch, which uses QString::replace(). \1 to \99 are replaced with the captured text as
+    // long as the pattern has that many groups, everything else is copied as is.
+    for (Sci::Position i = 0; i < *length; ++i) {
+        uint32_t group = 0;
+        Sci::Position digits = 0;
+
+        if (text[i] == '\\' && i + 1 < *length && text[i + 1] >= '1' && text[i + 1] <= '9') {
+            group = static_cast<uint32_t>(text[i + 1] - '0');
+            digits = 1;
+
+            if (i + 2 < *length && text[i + 2] >= '0' && text[i + 2] <= '9' && group * 10 + static_cast<uint32_t>(text[i + 2] - '0') <= captureCount) {
+                group = group * 10 + static_cast<uint32_t>(text[i + 2] - '0');
+                digits = 2;
+            }
+        }
+
+        if (digits == 0 || group > captureCount) {
+            substituted.push_back(text[i]);
+            continue;
+        }
+
+        if (group < groupStart.size() && groupStart[group] >= 0 && groupEnd[group] > groupStart[group]) {
+            const Sci::Position groupLength = groupEnd[group] - groupStart[group];
+            substituted.append(doc->RangePointer(groupStart[group], groupLength), groupLength);
+        }
+
+        i += digits;
+    }
+
+    *length = static_cast<Sci::Position>(substituted.length());
+    return substituted.c_str();
+}
+
+bool Pcre2RegexSearch::compile(const char *s, uint32_t options)
+{
+    if (code != Q_NULLPTR && pattern == s && patternOptions == options) {
+        return true;
+    }
+
+    releasePattern();
+
+    int errorCode;
+    PCRE2_SIZE errorOffset;
+    code = pcre2_compile(reinterpret_cast<PCRE2_SPTR>(s), PCRE2_ZERO_TERMINATED, options, &errorCode, &errorOffset, Q_NULLPTR);
+
+    if (code == Q_NULLPTR) {
+        qWarning("pcre2_compile() failed at offset %d: %s", static_cast<int>(errorOffset), errorMessage(errorCode).constData());
+        return false;
+    }
+
+    pattern = s;
+    patternOptions = options;
+
+    // If JIT is not supported on this platform the interpreter still works, just slower. Partial matching is used
+    // around the gap so it gets compiled as well.
+    const int jitResult = pcre2_jit_compile(code, PCRE2_JIT_COMPLETE | PCRE2_JIT_PARTIAL_HARD);
+    if (jitResult != 0) {
+        qDebug("pcre2_jit_compile() failed: %s", errorMessage(jitResult).constData());
+    }
+
+    matchData = pcre2_match_data_create_from_pattern(code, Q_NULLPTR);
+
+    // This is in characters, which are up to 4 bytes in UTF-8
+    uint32_t maxLookbehind = 0;
+    pcre2_pattern_info(code, PCRE2_INFO_MAXLOOKBEHIND, &maxLookbehind);
+    lookbehindLength = static_cast<Sci::Position>(maxLookbehind) * 4;
+
+    pcre2_pattern_info(code, PCRE2_INFO_CAPTURECOUNT, &captureCount);
+
+    return true;
+}
+
+void Pcre2RegexSearch::releasePattern()
+{
+    pcre2_match_data_free(matchData);
+    matchData = Q_NULLPTR;
+
+    pcre2_code_free(code);
+    code = Q_NULLPTR;
+
+    pattern.clear();
+}
+
+int Pcre2RegexSearch::matchAt(Document *doc, Sci::Position subjectStart, Sci::Position startPos, Sci::Position maxPos)
+{
+    const Sci::Position gap = doc->GapPosition();
+
+    // The range is only contiguous in memory if it is all on one side of the gap. Making it contiguous moves the gap,
+    // which copies everything in between, so each side is matched on its own whenever that gives the same result.
+    if (gap > subjectStart && gap < maxPos) {
+        int rc = PCRE2_ERROR_NOMATCH;
+
+        // Anything that runs into the gap comes back as a partial match, so a complete match is the real one
+        if (startPos < gap) {
+            rc = matchSubject(doc->RangePointer(subjectStart, gap - subjectStart), subjectStart, gap, startPos, PCRE2_PARTIAL_HARD);
+        }
+
+        if (rc == PCRE2_ERROR_NOMATCH) {
+            // Nothing starts before the gap. The text after it can be matched by itself as long as the pattern doesn't
+            // need to look back across the gap.
+            const Sci::Position from = qMax(startPos, gap);
+
+            if (from - gap >= lookbehindLength) {
+                const uint32_t options = doc->LineStart(doc->SciLineFromPosition(gap)) == gap ? 0 : PCRE2_NOTBOL;
+
+                return matchSubject(doc->RangePointer(gap, maxPos - gap), gap, maxPos, from, options);
+            }
+        }
+        else if (rc != PCRE2_ERROR_PARTIAL) {
+            return rc;
+        }
+
+        // The match runs across the gap, so it has to be moved after all
+    }
+
+    return matchSubject(doc->RangePointer(subjectStart, maxPos - subjectStart), subjectStart, maxPos, startPos, 0);
+}
+
+int Pcre2RegexSearch::matchSubject(const char *subject, Sci::Position subjectStart, Sci::Position subjectEnd, Sci::Position startPos, uint32_t options)
+{
+    const int rc = pcre2_match(code, reinterpret_cast<PCRE2_SPTR>(subject), subjectEnd - subjectStart, startPos - subjectStart, options, matchData, matchContext);
+
+    if (rc < 0) {
+        if (rc != PCRE2_ERROR_NOMATCH && rc != PCRE2_ERROR_PARTIAL) {
+            qWarning("pcre2_match() failed: %s", errorMessage(rc).constData());
+        }
+
+        return rc;
+    }
+
+    // The offsets are relative to the subject which are already in bytes
+    const PCRE2_SIZE *ovector = pcre2_get_ovector_pointer(matchData);
+    const uint32_t groups = pcre2_get_ovector_count(matchData);
+
+    groupStart.assign(groups, -1);
+    groupEnd.assign(groups, -1);
+
+    for (uint32_t i = 0; i < groups && i < static_cast<uint32_t>(rc); ++i) {
+        if (ovector[2 * i] != PCRE2_UNSET) {
+            groupStart[i] = subjectStart + static_cast<Sci::Position>(ovector[2 * i]);
+            groupEnd[i] = subjectStart + static_cast<Sci::Position>(ovector[2 * i + 1]);
+        }
+    }
+
+    return rc;
+}
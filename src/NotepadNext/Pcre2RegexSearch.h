@@ -0,0 +1,70 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PCRE2REGEXSEARCH_H
+#define PCRE2REGEXSEARCH_H
+
+#include <pcre2.h>
+
+#include <string>
+#include <vector>
+
+// Pulls in the Scintilla internals in the order they need to be included
+#include "QRegexSearch.h"
+
+
+// Searches the document's UTF-8 text in place using PCRE2, so unlike QRegexSearch nothing needs converted
+// to UTF-16 and the match offsets are already byte positions. The text on either side of the document's gap
+// is matched separately where possible so the gap doesn't get moved. The compiled pattern is kept until a
+// different pattern or set of flags is searched for.
+class Pcre2RegexSearch : public RegexSearchBase
+{
+public:
+    Pcre2RegexSearch();
+    ~Pcre2RegexSearch() override;
+
+    Sci::Position FindText(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s, bool caseSensitive, bool word, bool wordStart, Scintilla::FindOption flags, Sci::Position *length) override;
+    const char *SubstituteByPosition(Document *doc, const char *text, Sci::Position *length) override;
+
+private:
+    bool compile(const char *s, uint32_t options);
+    void releasePattern();
+    int matchAt(Document *doc, Sci::Position subjectStart, Sci::Position startPos, Sci::Position maxPos);
+    int matchSubject(const char *subject, Sci::Position subjectStart, Sci::Position subjectEnd, Sci::Position startPos, uint32_t options);
+
+    std::string pattern;
+    uint32_t patternOptions = 0;
+
+    // How many bytes before the start of a match the pattern can look at, at most
+    Sci::Position lookbehindLength = 0;
+    uint32_t captureCount = 0;
+
+    pcre2_code *code = Q_NULLPTR;
+    pcre2_match_data *matchData = Q_NULLPTR;
+    pcre2_match_context *matchContext = Q_NULLPTR;
+    pcre2_jit_stack *jitStack = Q_NULLPTR;
+
+    // Document positions of each group from the last match, -1 if the group did not participate
+    std::vector<Sci::Position> groupStart;
+    std::vector<Sci::Position> groupEnd;
+
+    std::string substituted;
+};
+
+#endif // PCRE2REGEXSEARCH_H
@@ -22,6 +22,10 @@
 #include <QtGlobal>
 #include <QRegularExpression>
 
+#ifdef NN_REGEX_PCRE2
+#include "Pcre2RegexSearch.h"
+#endif
+
 using namespace Scintilla;
 
 #ifdef SCI_OWNREGEX
@@ -31,7 +35,11 @@ RegexSearchBase *Scintilla::Internal::CreateRegexSearch(CharClassify *charClassT
 
     qInfo(Q_FUNC_INFO);
 
+#ifdef NN_REGEX_PCRE2
+    return new Pcre2RegexSearch();
+#else
     return new QRegexSearch();
+#endif
 }
 #endif
 
@@ -40,8 +48,21 @@ QRegexSearch::QRegexSearch()
 
 }
 
+QRegexSearch::~QRegexSearch()
+{
+    if (watchedDocument) {
+        watchedDocument->RemoveWatcher(this, Q_NULLPTR);
+    }
+
+    delete substituted;
+}
+
 Sci::Position QRegexSearch::FindText(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s, bool caseSensitive, bool word, bool wordStart, Scintilla::FindOption flags, Sci::Position *length)
 {
+    Q_UNUSED(caseSensitive);
+    Q_UNUSED(word);
+    Q_UNUSED(wordStart);
+
     // -----------------------------------------------------------------------------------------------------------------------
     // NOTE: This section of code has to be very careful about what units of measure is being used. Scintilla wants to operate
     // in units of bytes (e.g. position 3 is 3 bytes into the text). Qt wants to operate in units of UTF16 chars. The trouble is
@@ -62,7 +83,7 @@ Sci::Position QRegexSearch::FindText(Document *doc, Sci::Position minPos, Sci::P
     //qInfo("\tflags %d", flags);
 
     // No need to search an empty range
-    if (minPos == maxPos)
+    if (minPos >= maxPos)
         return -1;
 
     auto options = QRegularExpression::MultilineOption | QRegularExpression::UseUnicodePropertiesOption;
@@ -71,17 +92,46 @@ Sci::Position QRegexSearch::FindText(Document *doc, Sci::Position minPos, Sci::P
         options |= QRegularExpression::CaseInsensitiveOption;
 
     // TODO: does (*ANYCRLF) need prepended to the search string?
-    QRegularExpression re(s, options);
-    if (!re.isValid())
+    const QRegularExpression &regex = compile(s, options);
+    if (!regex.isValid())
         return -1; // Invalid regular expression
 
-    // Get the bytes from the document. No need to go past maxPos bytes
-    // Not actually sure if this copies the data or not
-    const Sci::Position rangeLength = maxPos - minPos;
-    const QString utf8 = QString::fromUtf8(doc->RangePointer(minPos, rangeLength), rangeLength);
+    QRegularExpressionMatch m;
+    int offset;
+    Sci::Position neededEnd = minPos + 1;
+
+    forever {
+        prepareText(doc, minPos, maxPos, neededEnd);
+
+        // Work out where minPos is in the UTF-16 text, counting from the closest known position
+        if (minPos >= anchorPosition) {
+            offset = anchorOffset + static_cast<int>(doc->CountUTF16(anchorPosition, minPos));
+        }
+        else {
+            offset = static_cast<int>(doc->CountUTF16(cacheStart, minPos));
+        }
+
+        // When the text stops short of maxPos a hard partial match is asked for, so anything that ran into the
+        // end of the text (including $, \b and look aheads) comes back as partial instead of as a wrong match
+        const bool truncated = cacheEnd < maxPos;
+        const auto matchType = truncated ? QRegularExpression::PartialPreferFirstMatch : QRegularExpression::NormalMatch;
 
-    // NOTE: QString uses UTF16 counts since QChars are 16 bits
-    QRegularExpressionMatch m = re.match(utf8, 0, QRegularExpression::NormalMatch, QRegularExpression::NoMatchOption);
+        // NOTE: QString uses UTF16 counts since QChars are 16 bits
+        m = regex.match(text, offset, matchType, QRegularExpression::NoMatchOption);
+
+        if (m.hasPartialMatch()) {
+            // It might keep going past the end, so try again with at least twice as much text
+            neededEnd = cacheEnd + qMax(cacheEnd - minPos, TEXT_WINDOW);
+        }
+        else if (!m.hasMatch() && truncated) {
+            // Nothing starts in this part of the range, so move on to the next part
+            minPos = cacheEnd;
+            neededEnd = minPos + 1;
+        }
+        else {
+            break;
+        }
+    }
 
     if (!m.hasMatch())
         return -1; // No match
@@ -89,10 +139,14 @@ Sci::Position QRegexSearch::FindText(Document *doc, Sci::Position minPos, Sci::P
     match = m;
 
     // NOTE: Returned started is the index into the QString which uses UTF16
-    const int positionStart = doc->GetRelativePositionUTF16(minPos, match.capturedStart(0));
+    const Sci::Position positionStart = doc->GetRelativePositionUTF16(minPos, match.capturedStart(0) - offset);
 
     // Now move ahead however many characters we matched. Again, based on UTF16 count
-    const int positionEnd = doc->GetRelativePositionUTF16(positionStart, match.capturedLength(0));
+    const Sci::Position positionEnd = doc->GetRelativePositionUTF16(positionStart, match.capturedLength(0));
+
+    // The next search almost always starts where this one ended
+    anchorPosition = positionEnd;
+    anchorOffset = match.capturedEnd(0);
 
     // The length is the number of bytes that was matched
     *length = positionEnd - positionStart;
@@ -100,6 +154,105 @@ Sci::Position QRegexSearch::FindText(Document *doc, Sci::Position minPos, Sci::P
     return positionStart;
 }
 
+const QRegularExpression &QRegexSearch::compile(const char *s, QRegularExpression::PatternOptions options)
+{
+    const QString pattern = QString::fromUtf8(s);
+
+    if (re.pattern() != pattern || re.patternOptions() != options) {
+        re.setPattern(pattern);
+        re.setPatternOptions(options);
+
+        // It is going to be used for a lot of matches so JIT compile it now rather than after a few uses
+        re.optimize();
+    }
+
+    return re;
+}
+
+void QRegexSearch::prepareText(Document *doc, Sci::Position minPos, Sci::Position maxPos, Sci::Position neededEnd)
+{
+    if (watchedDocument != doc) {
+        if (watchedDocument) {
+            watchedDocument->RemoveWatcher(this, Q_NULLPTR);
+        }
+
+        watchedDocument = doc;
+        watchedDocument->AddWatcher(this, Q_NULLPTR);
+        textValid = false;
+    }
+
+    neededEnd = qMin(neededEnd, maxPos);
+
+    // Matches have to stop at maxPos, so the text can only be reused if it is for the same range
+    if (textValid && maxPos == searchEnd && minPos >= cacheStart && cacheEnd >= neededEnd) {
+        return;
+    }
+
+    // Only a window of the range is converted so the copy stays small no matter how big the document is. It starts
+    // a little before minPos, at the beginning of the line if it is close enough, so anchors and look behinds see the
+    // text before minPos.
+    cacheStart = doc->MovePositionOutsideChar(qMax(doc->LineStart(doc->SciLineFromPosition(minPos)), minPos - TEXT_CONTEXT), -1, false);
+    cacheEnd = doc->MovePositionOutsideChar(qMin(maxPos, qMax(neededEnd, minPos + TEXT_WINDOW)), -1, false);
+    searchEnd = maxPos;
+
+    // The window has to at least reach the end of the character at minPos
+    if (cacheEnd <= minPos) {
+        cacheEnd = qMin(maxPos, doc->NextPosition(minPos, 1));
+    }
+
+    text = QString::fromUtf8(doc->RangePointer(cacheStart, cacheEnd - cacheStart), static_cast<int>(cacheEnd - cacheStart));
+
+    anchorPosition = cacheStart;
+    anchorOffset = 0;
+    textValid = true;
+}
+
+void QRegexSearch::NotifyModifyAttempt(Document *doc, void *userData)
+{
+    Q_UNUSED(doc);
+    Q_UNUSED(userData);
+}
+
+void QRegexSearch::NotifySavePoint(Document *doc, void *userData, bool atSavePoint)
+{
+    Q_UNUSED(doc);
+    Q_UNUSED(userData);
+    Q_UNUSED(atSavePoint);
+}
+
+void QRegexSearch::NotifyModified(Document *doc, DocModification mh, void *userData)
+{
+    Q_UNUSED(doc);
+    Q_UNUSED(userData);
+
+    if (FlagSet(mh.modificationType, ModificationFlags::InsertText | ModificationFlags::DeleteText)) {
+        textValid = false;
+    }
+}
+
+void QRegexSearch::NotifyDeleted(Document *doc, void *userData) noexcept
+{
+    Q_UNUSED(doc);
+    Q_UNUSED(userData);
+
+    watchedDocument = Q_NULLPTR;
+    textValid = false;
+}
+
+void QRegexSearch::NotifyStyleNeeded(Document *doc, void *userData, Sci::Position endPos)
+{
+    Q_UNUSED(doc);
+    Q_UNUSED(userData);
+    Q_UNUSED(endPos);
+}
+
+void QRegexSearch::NotifyErrorOccurred(Document *doc, void *userData, Scintilla::Status status)
+{
+    Q_UNUSED(doc);
+    Q_UNUSED(userData);
+    Q_UNUSED(status);
+}
+
 const char *QRegexSearch::SubstituteByPosition(Document *doc, const char *text, Sci::Position *length)
 {
     Q_UNUSED(doc);
@@ -114,9 +267,7 @@ const char *QRegexSearch::SubstituteByPosition(Document *doc, const char *text,
     newString.replace(match.regularExpression(), QByteArray(text, *length));
 
     // TODO: figure out why this has to be new'd and can't be an instantiated class member
-    if (substituted) {
-        delete substituted;
-    }
+    delete substituted;
 
     substituted = new QByteArray(newString.toUtf8());
     *length = substituted->length();
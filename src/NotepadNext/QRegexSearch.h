@@ -20,6 +20,7 @@
 #ifndef QREGEXSEARCH_H
 #define QREGEXSEARCH_H
 
+#include <QRegularExpression>
 #include <QRegularExpressionMatch>
 
 #include <vector>
@@ -85,17 +86,49 @@
 
 using namespace Scintilla::Internal;
 
-class QRegexSearch : public RegexSearchBase
+// Each document gets its own instance. The compiled pattern and a window of the document text converted to
+// UTF-16 are kept between calls, since searching for every match calls FindText() over and over with the same
+// pattern and end position. The converted text gets thrown away as soon as the document is modified.
+class QRegexSearch : public RegexSearchBase, public DocWatcher
 {
 public:
     QRegexSearch();
+    ~QRegexSearch() override;
 
     Sci::Position FindText(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s, bool caseSensitive, bool word, bool wordStart, Scintilla::FindOption flags, Sci::Position *length) override;
     const char *SubstituteByPosition(Document *doc, const char *text, Sci::Position *length) override;
 
+    void NotifyModifyAttempt(Document *doc, void *userData) override;
+    void NotifySavePoint(Document *doc, void *userData, bool atSavePoint) override;
+    void NotifyModified(Document *doc, DocModification mh, void *userData) override;
+    void NotifyDeleted(Document *doc, void *userData) noexcept override;
+    void NotifyStyleNeeded(Document *doc, void *userData, Sci::Position endPos) override;
+    void NotifyErrorOccurred(Document *doc, void *userData, Scintilla::Status status) override;
+
 private:
+    const QRegularExpression &compile(const char *s, QRegularExpression::PatternOptions options);
+    void prepareText(Document *doc, Sci::Position minPos, Sci::Position maxPos, Sci::Position neededEnd);
+
     QRegularExpressionMatch match;
     QByteArray *substituted = Q_NULLPTR;
+
+    QRegularExpression re;
+
+    // How many bytes are converted at a time, and how far before minPos the text starts at most
+    static constexpr Sci::Position TEXT_WINDOW = 1024 * 1024;
+    static constexpr Sci::Position TEXT_CONTEXT = 256;
+
+    // Text from cacheStart up to cacheEnd of a search that ends at searchEnd, along with a position that is
+    // known in both bytes and UTF-16 so the next search can work out where it is without counting from the
+    // start again
+    Document *watchedDocument = Q_NULLPTR;
+    bool textValid = false;
+    QString text;
+    Sci::Position cacheStart = 0;
+    Sci::Position cacheEnd = 0;
+    Sci::Position searchEnd = 0;
+    Sci::Position anchorPosition = 0;
+    int anchorOffset = 0;
 };
 
 #endif // QREGEXSEARCH_H
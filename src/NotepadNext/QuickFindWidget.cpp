@@ -114,10 +114,10 @@ void QuickFindWidget::highlightMatches()
     editor->setIndicatorCurrent(indicator);
 
     bool foundOne = false;
-    finder->forEachMatch([&](int start, int end) {
+    finder->forEachMatch([&](Sci_Position start, Sci_Position end) {
         foundOne = true;
 
-        const int length = end - start;
+        const Sci_Position length = end - start;
 
         // Don't highlight 0 length matches
         if (length > 0)
@@ -143,7 +143,7 @@ void QuickFindWidget::navigateToNextMatch(bool skipCurrent)
         return;
     }
 
-    int startPos = INVALID_POSITION;
+    Sci_Position startPos = INVALID_POSITION;
     if (skipCurrent) {
         startPos = editor->selectionEnd();
     }
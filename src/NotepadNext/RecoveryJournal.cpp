@@ -0,0 +1,368 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "RecoveryJournal.h"
+#include "FileSaver.h"
+#include "ScintillaNext.h"
+#include "SessionManager.h"
+
+#include <QDataStream>
+#include <QSettings>
+#include <QUuid>
+#include <QtConcurrent>
+
+
+// Once the journal is bigger than this (and the buffer) it is cheaper to take a new snapshot
+const qint64 CHECKPOINT_SIZE = 4 * 1024 * 1024;
+
+const quint8 RECORD_INSERT = 'I';
+const quint8 RECORD_DELETE = 'D';
+
+
+RecoveryJournal::RecoveryJournal(ScintillaNext *editor, const QDir &directory) :
+    QObject(editor),
+    editor(editor),
+    directory(directory),
+    id(QUuid::createUuid().toString(QUuid::WithoutBraces))
+{
+    // Anything freshly read from disk can be rebuilt from the file itself
+    clean = editor->isFile() && !editor->isTemporary();
+
+    connect(editor, &ScintillaNext::modified, this, &RecoveryJournal::editorModified);
+    connect(editor, &ScintillaNext::savePointChanged, this, &RecoveryJournal::savePointChanged);
+    connect(&watcher, &QFutureWatcher<bool>::finished, this, &RecoveryJournal::flushFinished);
+}
+
+RecoveryJournal::~RecoveryJournal()
+{
+    // The editor is going away on purpose, so there is nothing left to recover
+    discard();
+}
+
+RecoveryJournal *RecoveryJournal::forEditor(const ScintillaNext *editor)
+{
+    return editor->findChild<RecoveryJournal *>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+QString RecoveryJournal::infoFilePath(const QDir &directory, const QString &id)
+{
+    return directory.filePath(QStringLiteral("%1.ini").arg(id));
+}
+
+QString RecoveryJournal::snapshotFilePath(const QDir &directory, const QString &id, int generation)
+{
+    return directory.filePath(QStringLiteral("%1.%2.snapshot").arg(id).arg(generation));
+}
+
+QString RecoveryJournal::journalFilePath(const QDir &directory, const QString &id, int generation)
+{
+    return directory.filePath(QStringLiteral("%1.%2.journal").arg(id).arg(generation));
+}
+
+void RecoveryJournal::flush()
+{
+    if (!active) {
+        return;
+    }
+
+    if (!pending.isEmpty()) {
+        journalSize += pending.size();
+        unwritten.append(qMakePair(generation, pending));
+        pending.clear();
+    }
+
+    if (journalSize > qMax<qint64>(CHECKPOINT_SIZE, editor->length())) {
+        checkpoint();
+    }
+
+    // Only one write at a time so the records stay in order
+    if (unwritten.isEmpty() || watcher.isRunning()) {
+        return;
+    }
+
+    QVector<QPair<QString, QByteArray>> writes;
+    for (const QPair<int, QByteArray> &entry : qAsConst(unwritten)) {
+        writes.append(qMakePair(journalFilePath(directory, id, entry.first), entry.second));
+    }
+    unwritten.clear();
+
+    watcher.setFuture(QtConcurrent::run([=]() {
+        for (const QPair<QString, QByteArray> &write : writes) {
+            QFile file(write.first);
+
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Append) || file.write(write.second) != write.second.size()) {
+                qWarning("Failed to write recovery journal \"%s\": %s", qUtf8Printable(write.first), qUtf8Printable(file.errorString()));
+                return false;
+            }
+        }
+
+        return true;
+    }));
+}
+
+bool RecoveryJournal::replay(ScintillaNext *editor, const QDir &directory, const QString &id, int generation)
+{
+    qInfo(Q_FUNC_INFO);
+
+    editor->beginUndoAction();
+
+    // Every journal after the base applies on top of the one before it
+    for (int g = generation; QFile::exists(journalFilePath(directory, id, g)); ++g) {
+        QFile file(journalFilePath(directory, id, g));
+
+        if (!file.open(QIODevice::ReadOnly)) {
+            editor->endUndoAction();
+            return false;
+        }
+
+        QDataStream stream(&file);
+
+        while (!stream.atEnd()) {
+            quint8 type;
+            qint64 position;
+
+            stream >> type >> position;
+
+            if (type == RECORD_INSERT) {
+                QByteArray text;
+                stream >> text;
+
+                // The last record is cut short if the crash happened while it was being written
+                if (stream.status() != QDataStream::Ok) {
+                    break;
+                }
+
+                editor->setTargetRange(position, position);
+                editor->replaceTarget(text.size(), text.constData());
+            }
+            else if (type == RECORD_DELETE) {
+                qint64 length;
+                stream >> length;
+
+                if (stream.status() != QDataStream::Ok) {
+                    break;
+                }
+
+                editor->deleteRange(position, length);
+            }
+            else {
+                qWarning("Unknown record in recovery journal \"%s\"", qUtf8Printable(file.fileName()));
+                break;
+            }
+        }
+    }
+
+    editor->endUndoAction();
+
+    return true;
+}
+
+void RecoveryJournal::editorModified(Scintilla::ModificationFlags type, Scintilla::Position position, Scintilla::Position length, Scintilla::Position linesAdded, const QByteArray &text)
+{
+    Q_UNUSED(linesAdded)
+
+    const bool inserted = Scintilla::FlagSet(type, Scintilla::ModificationFlags::InsertText);
+    const bool deleted = Scintilla::FlagSet(type, Scintilla::ModificationFlags::DeleteText);
+
+    if (!inserted && !deleted) {
+        return;
+    }
+
+    if (!active) {
+        // Only the user's edits are worth recovering, a read-only editor is only changed by reloading the file.
+        // This is checked here rather than when the journal is attached since editors are read-only while loading.
+        if (editor->readOnly()) {
+            return;
+        }
+
+        // The snapshot already has this change in it
+        if (!start()) {
+            return;
+        }
+    }
+
+    // Just add it to the buffer, it doesn't hit the disk until the next flush
+    QDataStream stream(&pending, QIODevice::WriteOnly | QIODevice::Append);
+
+    if (inserted) {
+        stream << RECORD_INSERT << static_cast<qint64>(position) << text;
+    }
+    else {
+        stream << RECORD_DELETE << static_cast<qint64>(position) << static_cast<qint64>(length);
+    }
+}
+
+void RecoveryJournal::savePointChanged(bool dirty)
+{
+    // Everything is safely on disk now. Undoing back to the save point of a document that replaced a modified
+    // one doesn't count, since its text still isn't on disk.
+    if (!dirty && !editor->isModifiedIncludingDocumentSwap()) {
+        discard();
+        clean = editor->isFile() && !editor->isTemporary();
+    }
+}
+
+void RecoveryJournal::flushFinished()
+{
+    removeOldGenerations();
+
+    // Catch up on anything that came in while this write was running
+    if (!unwritten.isEmpty()) {
+        flush();
+    }
+}
+
+bool RecoveryJournal::start()
+{
+    qInfo(Q_FUNC_INFO);
+
+    active = true;
+    generation = 0;
+    baseGeneration = 0;
+    oldestGeneration = 0;
+    journalSize = 0;
+
+    // Starting from the file only works if it is still the same when the journal gets replayed, which is
+    // likely not the case for files that get written by something else. It is only worth the risk when the
+    // file is too big to make a copy of every time editing starts.
+    if (clean && editor->length() > CHECKPOINT_SIZE) {
+        writeInfo(true);
+        return true;
+    }
+
+    // The first snapshot becomes the base
+    checkpoint();
+    return false;
+}
+
+void RecoveryJournal::checkpoint()
+{
+    // The last snapshot is still being written out
+    if (snapshotSaver) {
+        return;
+    }
+
+    qInfo(Q_FUNC_INFO);
+
+    if (!pending.isEmpty()) {
+        unwritten.append(qMakePair(generation, pending));
+        pending.clear();
+    }
+
+    const int snapshotGeneration = ++generation;
+    const QString snapshotId = id;
+    journalSize = 0;
+
+    FileSaver *saver = editor->saveCopyInBackground(snapshotFilePath(directory, id, snapshotGeneration), FileEncoding());
+    snapshotSaver = saver;
+
+    connect(saver, &FileSaver::finished, this, [=](QFileDevice::FileError error) {
+        saver->deleteLater();
+        snapshotSaver.clear();
+
+        // It was thrown away while the snapshot was being written
+        if (!active || snapshotId != id) {
+            QFile::remove(snapshotFilePath(directory, snapshotId, snapshotGeneration));
+            return;
+        }
+
+        snapshotFinished(snapshotGeneration, error == QFileDevice::NoError);
+    });
+}
+
+void RecoveryJournal::snapshotFinished(int snapshotGeneration, bool success)
+{
+    // Without the snapshot the older journals are still needed to get to this point
+    if (!success) {
+        return;
+    }
+
+    baseGeneration = snapshotGeneration;
+    writeInfo(false);
+
+    removeOldGenerations();
+}
+
+void RecoveryJournal::writeInfo(bool baseIsFile)
+{
+    QSettings info(infoFilePath(directory, id), QSettings::IniFormat);
+
+    info.setValue("Name", editor->getName());
+    info.setValue("FilePath", editor->isFile() ? editor->getFilePath() : QString());
+    info.setValue("Encoding", QString::fromLatin1(editor->getEncoding().codecName));
+    info.setValue("EncodingHasBom", editor->getEncoding().hasBom);
+    info.setValue("Generation", baseGeneration);
+    info.setValue("BaseIsFile", baseIsFile);
+    info.setValue("SessionFileName", SessionManager::sessionFileName(editor));
+
+    if (baseIsFile) {
+        const QFileInfo fileInfo = editor->getFileInfo();
+
+        info.setValue("FileSize", fileInfo.size());
+        info.setValue("FileModified", fileInfo.lastModified());
+    }
+}
+
+void RecoveryJournal::removeOldGenerations()
+{
+    // The worker could still be appending to one of them
+    if (watcher.isRunning()) {
+        return;
+    }
+
+    QMutableVectorIterator<QPair<int, QByteArray>> it(unwritten);
+    while (it.hasNext()) {
+        if (it.next().first < baseGeneration)
+            it.remove();
+    }
+
+    for (; oldestGeneration < baseGeneration; ++oldestGeneration) {
+        QFile::remove(snapshotFilePath(directory, id, oldestGeneration));
+        QFile::remove(journalFilePath(directory, id, oldestGeneration));
+    }
+}
+
+void RecoveryJournal::discard()
+{
+    if (!active) {
+        return;
+    }
+
+    qInfo(Q_FUNC_INFO);
+
+    active = false;
+    pending.clear();
+    unwritten.clear();
+
+    watcher.waitForFinished();
+
+    if (snapshotSaver) {
+        snapshotSaver->waitForFinished();
+    }
+
+    QFile::remove(infoFilePath(directory, id));
+
+    for (int g = oldestGeneration; g <= generation; ++g) {
+        QFile::remove(snapshotFilePath(directory, id, g));
+        QFile::remove(journalFilePath(directory, id, g));
+    }
+
+    // Start over with a fresh id so a snapshot that is still being written can't be mixed up with a new journal
+    id = QUuid::createUuid().toString(QUuid::WithoutBraces);
+}
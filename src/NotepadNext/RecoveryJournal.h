@@ -0,0 +1,95 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RECOVERYJOURNAL_H
+#define RECOVERYJOURNAL_H
+
+#include <QDir>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QPair>
+#include <QPointer>
+#include <QVector>
+
+#include "ScintillaTypes.h"
+
+
+class FileSaver;
+class ScintillaNext;
+
+// Attached to an editor to keep a record of its unsaved changes on disk so they can be recovered if the
+// application crashes. Each insertion and deletion is appended to a journal, which gets written out on a
+// worker thread whenever it is flushed. The journal starts either from the file on disk or from a snapshot
+// of the buffer, and once it grows bigger than the buffer a new snapshot is taken so it can start over.
+class RecoveryJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RecoveryJournal(ScintillaNext *editor, const QDir &directory);
+    ~RecoveryJournal() override;
+
+    // Null if the editor doesn't have a journal
+    static RecoveryJournal *forEditor(const ScintillaNext *editor);
+
+    // Writes any pending records in the background
+    void flush();
+
+    // Rebuilds the editor's text from the files in the directory with the given id. The editor must
+    // already hold the base the journal started from.
+    static bool replay(ScintillaNext *editor, const QDir &directory, const QString &id, int generation);
+
+    static QString infoFilePath(const QDir &directory, const QString &id);
+    static QString snapshotFilePath(const QDir &directory, const QString &id, int generation);
+    static QString journalFilePath(const QDir &directory, const QString &id, int generation);
+
+private slots:
+    void editorModified(Scintilla::ModificationFlags type, Scintilla::Position position, Scintilla::Position length, Scintilla::Position linesAdded, const QByteArray &text);
+    void savePointChanged(bool dirty);
+    void flushFinished();
+
+private:
+    // Returns true if the journal starts from the file, otherwise from a snapshot of the buffer
+    bool start();
+    void checkpoint();
+    void snapshotFinished(int snapshotGeneration, bool success);
+    void writeInfo(bool baseIsFile);
+    void removeOldGenerations();
+    void discard();
+
+    ScintillaNext *editor;
+    QDir directory;
+    QString id;
+
+    bool active = false;
+    bool clean;
+    // Records go into the current generation's journal. Recovery starts from the base generation (either the
+    // file or the last complete snapshot) and replays every journal from there on.
+    int generation = 0;
+    int baseGeneration = 0;
+    int oldestGeneration = 0;
+    qint64 journalSize = 0;
+
+    QByteArray pending;
+    QVector<QPair<int, QByteArray>> unwritten;
+    QFutureWatcher<bool> watcher;
+    QPointer<FileSaver> snapshotSaver;
+};
+
+#endif // RECOVERYJOURNAL_H
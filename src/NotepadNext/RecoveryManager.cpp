@@ -0,0 +1,235 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "RecoveryManager.h"
+#include "EditorManager.h"
+#include "PagedFileView.h"
+#include "RecoveryJournal.h"
+#include "ScintillaNext.h"
+#include "SessionManager.h"
+
+#include <QSettings>
+#include <QStandardPaths>
+
+
+// How often the journals get written to disk
+const int FLUSH_INTERVAL = 2000;
+
+
+RecoveryManager::RecoveryManager(EditorManager *manager, QObject *parent) :
+    QObject(parent),
+    manager(manager)
+{
+    flushTimer.setInterval(FLUSH_INTERVAL);
+
+    connect(&flushTimer, &QTimer::timeout, this, &RecoveryManager::flushJournals);
+    connect(manager, &EditorManager::editorCreated, this, &RecoveryManager::attachJournal);
+
+    flushTimer.start();
+}
+
+int RecoveryManager::recover()
+{
+    qInfo(Q_FUNC_INFO);
+
+    const QDir d = recoveryDirectory();
+    QStringList ids;
+
+    for (const QString &infoFile : d.entryList({QStringLiteral("*.ini")}, QDir::Files)) {
+        ids.append(QFileInfo(infoFile).completeBaseName());
+    }
+
+    // Anything without an info file never got far enough to be recovered
+    for (const QString &f : d.entryList(QDir::Files)) {
+        if (!ids.contains(f.section('.', 0, 0))) {
+            d.remove(f);
+        }
+    }
+
+    int recovered = 0;
+
+    unrecovered.clear();
+
+    for (const QString &id : qAsConst(ids)) {
+        if (recoverBuffer(id) != Q_NULLPTR) {
+            ++recovered;
+        }
+        else {
+            removeFiles(id);
+        }
+    }
+
+    return recovered;
+}
+
+void RecoveryManager::clear()
+{
+    qInfo(Q_FUNC_INFO);
+
+    flushTimer.stop();
+
+    QDir d = recoveryDirectory();
+
+    for (const QString &f : d.entryList(QDir::Files)) {
+        d.remove(f);
+    }
+}
+
+void RecoveryManager::attachJournal(ScintillaNext *editor)
+{
+    // Paged views can't be edited, they only swap in a different part of the file as they move
+    if (PagedFileView::forEditor(editor) != Q_NULLPTR) {
+        return;
+    }
+
+    journals.append(new RecoveryJournal(editor, recoveryDirectory()));
+}
+
+void RecoveryManager::flushJournals()
+{
+    QMutableListIterator<QPointer<RecoveryJournal>> it(journals);
+
+    while (it.hasNext()) {
+        const QPointer<RecoveryJournal> journal = it.next();
+
+        if (journal.isNull())
+            it.remove();
+        else
+            journal->flush();
+    }
+}
+
+QDir RecoveryManager::unrecoveredDirectory() const
+{
+    QDir d = recoveryDirectory();
+
+    d.mkpath("unrecovered");
+    d.cd("unrecovered");
+
+    return d;
+}
+
+QDir RecoveryManager::recoveryDirectory() const
+{
+    QDir d(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+
+    d.mkpath("recovery");
+    d.cd("recovery");
+
+    return d;
+}
+
+ScintillaNext *RecoveryManager::recoverBuffer(const QString &id)
+{
+    const QDir d = recoveryDirectory();
+    const QSettings info(RecoveryJournal::infoFilePath(d, id), QSettings::IniFormat);
+
+    const QString name = info.value("Name").toString();
+    const QString filePath = info.value("FilePath").toString();
+    const int generation = info.value("Generation").toInt();
+
+    FileEncoding encoding;
+    encoding.codecName = info.value("Encoding").toString().toLatin1();
+    encoding.hasBom = info.value("EncodingHasBom").toBool();
+
+    qDebug("Recovering \"%s\"", qUtf8Printable(filePath.isEmpty() ? name : filePath));
+
+    ScintillaNext *editor = Q_NULLPTR;
+
+    if (info.value("BaseIsFile").toBool()) {
+        // The journal only makes sense on top of the exact file it started from
+        const QFileInfo fileInfo(filePath);
+
+        if (!fileInfo.exists() || fileInfo.size() != info.value("FileSize").toLongLong() || fileInfo.lastModified() != info.value("FileModified").toDateTime()) {
+            qWarning("  \"%s\" has changed since, unable to recover", qUtf8Printable(filePath));
+
+            // Don't throw away the only copy of the changes, even if they can't be applied
+            unrecovered.append(filePath);
+            keepFiles(id);
+            return Q_NULLPTR;
+        }
+
+        editor = manager->openFile(filePath);
+    }
+    else {
+        const QString snapshotPath = RecoveryJournal::snapshotFilePath(d, id, generation);
+
+        if (!QFileInfo::exists(snapshotPath)) {
+            qWarning("  snapshot is missing, unable to recover");
+            return Q_NULLPTR;
+        }
+
+        editor = ScintillaNext::fromFile(snapshotPath, false, manager->documentOptionsForFile(filePath.isEmpty() ? snapshotPath : filePath));
+
+        if (editor != Q_NULLPTR) {
+            if (QFileInfo::exists(filePath)) {
+                editor->setFileInfo(filePath);
+            }
+            else {
+                editor->detachFileInfo(name);
+            }
+        }
+    }
+
+    if (editor == Q_NULLPTR) {
+        return Q_NULLPTR;
+    }
+
+    // It has changes that haven't been saved anywhere
+    editor->setTemporary(true);
+
+    // Takes the place of the buffer's entry in the session
+    if (!info.value("SessionFileName").toString().isEmpty()) {
+        SessionManager::setSessionFileName(editor, info.value("SessionFileName").toString());
+    }
+
+    connect(editor, &ScintillaNext::loadFinished, this, [=](bool success) {
+        if (success) {
+            RecoveryJournal::replay(editor, d, id, generation);
+            editor->setEncoding(encoding);
+        }
+
+        // The editor has its own journal now
+        removeFiles(id);
+    });
+
+    manager->manageEditor(editor);
+
+    return editor;
+}
+
+void RecoveryManager::removeFiles(const QString &id) const
+{
+    QDir d = recoveryDirectory();
+
+    for (const QString &f : d.entryList({id + QStringLiteral(".*")}, QDir::Files)) {
+        d.remove(f);
+    }
+}
+
+void RecoveryManager::keepFiles(const QString &id) const
+{
+    QDir d = recoveryDirectory();
+    const QDir kept = unrecoveredDirectory();
+
+    // Moved out of the way since everything in the recovery directory is removed on a clean shut down
+    for (const QString &f : d.entryList({id + QStringLiteral(".*")}, QDir::Files)) {
+        d.rename(f, kept.filePath(f));
+    }
+}
@@ -0,0 +1,71 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RECOVERYMANAGER_H
+#define RECOVERYMANAGER_H
+
+#include <QDir>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+#include <QTimer>
+
+
+class EditorManager;
+class RecoveryJournal;
+class ScintillaNext;
+
+// Gives every editor a recovery journal and periodically flushes them to disk. Anything left in the
+// recovery directory when the application starts means it didn't shut down cleanly last time.
+class RecoveryManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RecoveryManager(EditorManager *manager, QObject *parent = nullptr);
+
+    // Reopens the buffers left behind by a crash, returns how many were recovered
+    int recover();
+
+    // Buffers recover() had to leave alone, their files are kept in unrecoveredDirectory()
+    QStringList unrecoveredBuffers() const { return unrecovered; }
+    QDir unrecoveredDirectory() const;
+
+    // Called once everything has been shut down properly
+    void clear();
+
+private slots:
+    void attachJournal(ScintillaNext *editor);
+    void flushJournals();
+
+private:
+    QDir recoveryDirectory() const;
+    ScintillaNext *recoverBuffer(const QString &id);
+
+    void removeFiles(const QString &id) const;
+    void keepFiles(const QString &id) const;
+
+    EditorManager *manager;
+    QStringList unrecovered;
+    QTimer flushTimer;
+    QList<QPointer<RecoveryJournal>> journals;
+};
+
+#endif // RECOVERYMANAGER_H
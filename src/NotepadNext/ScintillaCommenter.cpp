@@ -27,30 +27,30 @@ ScintillaCommenter::ScintillaCommenter(ScintillaNext *editor) :
 
 void ScintillaCommenter::toggleSelection()
 {
-    editor->forEachLineInSelection(editor->mainSelection(), [&](int line) {
+    editor->forEachLineInSelection(editor->mainSelection(), [&](Sci_Position line) {
         toggleLine(line);
     });
 }
 
 void ScintillaCommenter::commentSelection()
 {
-    editor->forEachLineInSelection(editor->mainSelection(), [&](int line) {
+    editor->forEachLineInSelection(editor->mainSelection(), [&](Sci_Position line) {
         commentLine(line);
     });
 }
 
 void ScintillaCommenter::uncommentSelection()
 {
-    editor->forEachLineInSelection(editor->mainSelection(), [&](int line) {
+    editor->forEachLineInSelection(editor->mainSelection(), [&](Sci_Position line) {
         uncommentLine(line);
     });
 }
 
-void ScintillaCommenter::toggleLine(int line)
+void ScintillaCommenter::toggleLine(Sci_Position line)
 {
     auto indentPos = editor->lineIndentPosition(line);
-    auto lineEnd = qMin(indentPos + editor->languageSingleLineComment.length(), editor->lineEndPosition(line));
-    const QByteArray commentText = editor->get_text_range(indentPos, lineEnd);
+    auto lineEnd = qMin<Sci_Position>(indentPos + editor->languageSingleLineComment.length(), editor->lineEndPosition(line));
+    const QByteArray commentText = editor->textRangeFull(indentPos, lineEnd);
 
     if (commentText == editor->languageSingleLineComment) {
         editor->deleteRange(indentPos, editor->languageSingleLineComment.length());
@@ -68,7 +68,7 @@ void ScintillaCommenter::toggleLine(int line)
     }
 }
 
-void ScintillaCommenter::commentLine(int line)
+void ScintillaCommenter::commentLine(Sci_Position line)
 {
     auto indentPos = editor->lineIndentPosition(line);
 
@@ -82,11 +82,11 @@ void ScintillaCommenter::commentLine(int line)
     st.trackInsertion(indentPos, editor->languageSingleLineComment.length());
 }
 
-void ScintillaCommenter::uncommentLine(int line)
+void ScintillaCommenter::uncommentLine(Sci_Position line)
 {
     auto indentPos = editor->lineIndentPosition(line);
-    auto lineEnd = qMin(indentPos + editor->languageSingleLineComment.length(), editor->lineEndPosition(line));
-    const QByteArray commentText = editor->get_text_range(indentPos, lineEnd);
+    auto lineEnd = qMin<Sci_Position>(indentPos + editor->languageSingleLineComment.length(), editor->lineEndPosition(line));
+    const QByteArray commentText = editor->textRangeFull(indentPos, lineEnd);
 
     if (commentText == editor->languageSingleLineComment) {
         editor->deleteRange(indentPos, editor->languageSingleLineComment.length());
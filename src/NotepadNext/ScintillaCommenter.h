@@ -34,9 +34,9 @@ public:
     void uncommentSelection();
 
 private:
-    void toggleLine(int line);
-    void commentLine(int line);
-    void uncommentLine(int line);
+    void toggleLine(Sci_Position line);
+    void commentLine(Sci_Position line);
+    void uncommentLine(Sci_Position line);
 
     ScintillaNext *editor;
     SelectionTracker st;
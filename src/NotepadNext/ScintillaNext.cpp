@@ -19,37 +19,59 @@
 
 #include "ScintillaNext.h"
 #include "ScintillaCommenter.h"
+#include "FileLoader.h"
+#include "FileReader.h"
+#include "EncodingWriter.h"
+#include "FileLoadingBar.h"
+#include "FileReloader.h"
+#include "FileSaver.h"
+#include "PagedFileView.h"
 
-#include "uchardet.h"
 #include <cinttypes>
 
 #include <QDir>
 #include <QMouseEvent>
 #include <QSaveFile>
-#include <QTextCodec>
+#include <QThreadPool>
 
+#if defined(Q_OS_UNIX)
+#include <sys/stat.h>
+#elif defined(Q_OS_WIN)
+#include <qt_windows.h>
+#endif
 
-const int CHUNK_SIZE = 1024 * 1024 * 4; // Not sure what is best
 
+const qint64 SNAPSHOT_CHUNK_SIZE = 1024 * 1024 * 4;
+const qint64 APPEND_CHUNK_SIZE = 1024 * 1024 * 4;
+const qint64 APPEND_CHECK_SIZE = 4096;
 
-static QFileDevice::FileError writeToDisk(const QByteArray &data, const QString &path)
+
+// Identifies the file itself rather than its path, so it is possible to tell when a file gets replaced
+static quint64 fileIdentity(const QString &filePath)
 {
-    qInfo(Q_FUNC_INFO);
+#if defined(Q_OS_UNIX)
+    struct stat info;
 
-    QSaveFile file(path);
-    file.setDirectWriteFallback(true);
+    if (::stat(QFile::encodeName(filePath).constData(), &info) == 0) {
+        return (static_cast<quint64>(info.st_dev) << 32) ^ static_cast<quint64>(info.st_ino);
+    }
+#elif defined(Q_OS_WIN)
+    HANDLE handle = CreateFileW(reinterpret_cast<LPCWSTR>(filePath.utf16()), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
 
-    if (file.open(QIODevice::WriteOnly)) {
-        if (file.write(data) != -1) {
-            if (file.commit()) {
-                return QFileDevice::NoError;
-            }
+    if (handle != INVALID_HANDLE_VALUE) {
+        BY_HANDLE_FILE_INFORMATION info;
+        quint64 identity = 0;
+
+        if (GetFileInformationByHandle(handle, &info)) {
+            identity = (static_cast<quint64>(info.dwVolumeSerialNumber) << 32) ^ ((static_cast<quint64>(info.nFileIndexHigh) << 32) | info.nFileIndexLow);
         }
+
+        CloseHandle(handle);
+        return identity;
     }
+#endif
 
-    // If it got to this point there was an error
-    qWarning("writeToDisk() failure code %d: %s", file.error(), qPrintable(file.errorString()));
-    return file.error();
+    return 0;
 }
 
 static bool isNewlineCharacter(char c)
@@ -66,13 +88,20 @@ ScintillaNext::ScintillaNext(QString name, QWidget *parent) :
     indicatorResources.disableRange(0, 7);
     indicatorResources.disableRange(INDICATOR_IME, INDICATOR_IME_MAX);
     indicatorResources.disableRange(INDICATOR_HISTORY_REVERTED_TO_ORIGIN_INSERTION, INDICATOR_HISTORY_REVERTED_TO_MODIFIED_DELETION);
+
+    // Keep track of changes so a background save knows if the buffer changed while it was being written
+    connect(this, &ScintillaNext::modified, this, [=](Scintilla::ModificationFlags type) {
+        if (Scintilla::FlagSet(type, Scintilla::ModificationFlags::InsertText) || Scintilla::FlagSet(type, Scintilla::ModificationFlags::DeleteText)) {
+            ++modificationCount;
+        }
+    });
 }
 
 ScintillaNext::~ScintillaNext()
 {
 }
 
-ScintillaNext *ScintillaNext::fromFile(const QString &filePath, bool tryToCreate)
+ScintillaNext *ScintillaNext::fromFile(const QString &filePath, bool tryToCreate, int documentOptions)
 {
     QFile file(filePath);
     ScintillaNext *editor = new ScintillaNext(file.fileName());
@@ -87,14 +116,16 @@ ScintillaNext *ScintillaNext::fromFile(const QString &filePath, bool tryToCreate
         f.close();
     }
 
-    bool readSuccessful = editor->readFromDisk(file);
-
-    if (!readSuccessful) {
+    // Make sure the file can actually be read before handing it off to the background loader
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning("QFile::open() failed when opening \"%s\" - error code %d: %s", qUtf8Printable(file.fileName()), file.error(), qUtf8Printable(file.errorString()));
         delete editor;
         return Q_NULLPTR;
     }
+    file.close();
 
     editor->setFileInfo(filePath);
+    editor->loadInBackground(filePath, documentOptions);
 
     return editor;
 }
@@ -104,7 +135,7 @@ int ScintillaNext::allocateIndicator(const QString &name)
     return indicatorResources.requestResource(name);
 }
 
-void ScintillaNext::goToRange(const Sci_CharacterRange &range)
+void ScintillaNext::goToRange(const Sci_CharacterRangeFull &range)
 {
     qInfo(Q_FUNC_INFO);
 
@@ -118,6 +149,58 @@ void ScintillaNext::goToRange(const Sci_CharacterRange &range)
     }
 }
 
+QByteArray ScintillaNext::textRangeFull(Sci_Position start, Sci_Position end)
+{
+    if (end <= start) {
+        return QByteArray();
+    }
+
+    // One extra byte for the terminating NUL Scintilla writes
+    QByteArray text(static_cast<int>(end - start) + 1, Qt::Uninitialized);
+    Sci_TextRangeFull tr {{start, end}, text.data()};
+
+    send(SCI_GETTEXTRANGEFULL, 0, reinterpret_cast<sptr_t>(&tr));
+    text.chop(1);
+
+    return text;
+}
+
+Sci_Position ScintillaNext::findTextFull(int flags, Sci_TextToFindFull *ttf)
+{
+    const QByteArray text = QByteArray::fromRawData(ttf->lpstrText, qstrlen(ttf->lpstrText));
+    const bool matchCase = flags & SCFIND_MATCHCASE;
+
+    // A range from high to low searches backwards
+    if (ttf->chrg.cpMin > ttf->chrg.cpMax || !canSearchLiterally(flags, text, codePage())) {
+        return send(SCI_FINDTEXTFULL, flags, reinterpret_cast<sptr_t>(ttf));
+    }
+
+    if (!matchCase) {
+        if (foldedSearch.text() != text) {
+            foldedSearch = LiteralSearch::FoldedSearch(QByteArray(text.constData(), text.size()));
+        }
+
+        if (!foldedSearch.isValid()) {
+            return send(SCI_FINDTEXTFULL, flags, reinterpret_cast<sptr_t>(ttf));
+        }
+    }
+
+    const Sci_Position end = qMin<Sci_Position>(ttf->chrg.cpMax, length());
+    Sci_Position pos = qMax<Sci_Position>(ttf->chrg.cpMin, 0);
+    Sci_Position matchLength = 0;
+
+    while ((pos = findLiteral(pos, end, text, matchCase, &matchLength)) != INVALID_POSITION) {
+        if (!(flags & SCFIND_WHOLEWORD) || isRangeWord(pos, pos + matchLength)) {
+            ttf->chrgText = {pos, pos + matchLength};
+            return pos;
+        }
+
+        pos++;
+    }
+
+    return INVALID_POSITION;
+}
+
 QByteArray ScintillaNext::eolString() const
 {
     const int eol = eOLMode();
@@ -127,12 +210,12 @@ QByteArray ScintillaNext::eolString() const
     else return QByteArrayLiteral("\r");
 }
 
-bool ScintillaNext::lineIsEmpty(int line)
+bool ScintillaNext::lineIsEmpty(Sci_Position line)
 {
     return (lineEndPosition(line) - positionFromLine(line)) == 0;
 }
 
-void ScintillaNext::deleteLine(int line)
+void ScintillaNext::deleteLine(Sci_Position line)
 {
     deleteRange(positionFromLine(line), lineLength(line));
 }
@@ -157,8 +240,8 @@ void ScintillaNext::deleteLeadingEmptyLines()
 
 void ScintillaNext::deleteTrailingEmptyLines()
 {
-    const int docLength = length();
-    int position = docLength;
+    const Sci_Position docLength = length();
+    Sci_Position position = docLength;
 
     while (position > 0 && isNewlineCharacter(charAt(position - 1))) {
         position--;
@@ -179,8 +262,8 @@ bool ScintillaNext::canSaveToDisk() const
     // - A modified file
     // - A missing file since as soon as it is saved it is no longer missing.
     return temporary ||
-           (bufferType == ScintillaNext::New && modify()) ||
-           (bufferType == ScintillaNext::File && modify()) ||
+           (bufferType == ScintillaNext::New && isModifiedIncludingDocumentSwap()) ||
+           (bufferType == ScintillaNext::File && isModifiedIncludingDocumentSwap()) ||
             (bufferType == ScintillaNext::FileMissing);
 }
 
@@ -252,13 +335,17 @@ QFileDevice::FileError ScintillaNext::save()
 
     Q_ASSERT(isFile());
 
+    waitForLoad();
+    waitForSave();
+
     emit aboutToSave();
 
-    QFileDevice::FileError writeSuccessful = writeToDisk(QByteArray::fromRawData((char*)characterPointer(), textLength()), fileInfo.filePath());
+    QFileDevice::FileError writeSuccessful = writeToDisk(fileInfo.filePath());
 
     if (writeSuccessful == QFileDevice::NoError) {
         updateTimestamp();
-        setSavePoint();
+        updateDiskState(QFileInfo(fileInfo.filePath()).size());
+        setSavePointIncludingDocumentSwap();
 
         // If this was a temporary file, make sure it is not any more
         setTemporary(false);
@@ -273,11 +360,58 @@ void ScintillaNext::reload()
 {
     Q_ASSERT(isFile());
 
+    // A placeholder reads whatever is on disk once it is needed
+    if (isLoadDeferred() || isSaving()) {
+        return;
+    }
+
+    // What is being read may already be out of date, so pick up the changes once it is done
+    if (isLoading() || isReloading()) {
+        reloadPending = true;
+        return;
+    }
+
     // Ensure the file still exists.
     if (!QFile::exists(fileInfo.canonicalFilePath())) {
         return;
     }
 
+    // Only part of a paged file is in the editor, so it just needs re-indexed
+    if (PagedFileView *view = PagedFileView::forEditor(this)) {
+        updateTimestamp();
+        view->reload();
+        return;
+    }
+
+    // When following a file that only grew, just the new data needs read
+    if (following && appendFromDisk()) {
+        return;
+    }
+
+    // Too big to diff, so start over from scratch
+    if (!FileReloader::canReload(textLength()) || !FileReloader::canReload(QFileInfo(fileInfo.canonicalFilePath()).size())) {
+        reloadFully();
+        return;
+    }
+
+    reloadModificationCount = modificationCount;
+
+    fileReloader = new FileReloader(this, fileInfo.canonicalFilePath(), snapshot());
+    connect(fileReloader, &FileReloader::finished, this, &ScintillaNext::backgroundReloadFinished);
+    fileReloader->start();
+}
+
+void ScintillaNext::waitForReload()
+{
+    if (fileReloader) {
+        fileReloader->waitForFinished();
+    }
+}
+
+void ScintillaNext::reloadFully()
+{
+    qInfo(Q_FUNC_INFO);
+
     // Remove all the text
     {
         const QSignalBlocker blocker(this);
@@ -294,23 +428,270 @@ void ScintillaNext::reload()
 
     if (readSuccessful) {
         updateTimestamp();
-        setSavePoint();
+        setSavePointIncludingDocumentSwap();
     }
+}
+
+void ScintillaNext::backgroundReloadFinished(bool success)
+{
+    qInfo(Q_FUNC_INFO);
+
+    FileReloader *reloader = fileReloader;
+    fileReloader.clear();
+    reloader->deleteLater();
 
-    return;
+    if (!success) {
+        // The buffer is left alone rather than being emptied
+        qWarning("Failed to reload \"%s\"", qUtf8Printable(reloader->getFilePath()));
+    }
+    else if (modificationCount != reloadModificationCount) {
+        // The hunks no longer line up with the buffer, so try again
+        reloadPending = true;
+    }
+    else {
+        const QByteArray &text = reloader->getText();
+        const QVector<TextDiff::Hunk> &hunks = reloader->getHunks();
+
+        qInfo("Reloading %d changed hunks", static_cast<int>(hunks.size()));
+
+        const bool wasReadOnly = readOnly();
+        setReadOnly(false);
+
+        // Go backwards so the positions of the earlier hunks are not affected. Everything outside of
+        // the hunks (e.g. markers, folds, the scroll position) is left untouched.
+        beginUndoAction();
+        for (int i = hunks.size() - 1; i >= 0; --i) {
+            const TextDiff::Hunk &hunk = hunks[i];
+
+            setTargetRange(hunk.oldStart, hunk.oldStart + hunk.oldLength);
+            replaceTarget(hunk.newLength, text.constData() + hunk.newStart);
+        }
+        endUndoAction();
+
+        setReadOnly(wasReadOnly);
+
+        fileAnalysis = reloader->getAnalysis();
+        applyFileAnalysis();
+        setEncoding(reloader->getEncoding());
+        updateDiskState(reloader->getBytesRead());
+
+        if (!QFileInfo(reloader->getFilePath()).isWritable()) {
+            qInfo("Setting file as read-only");
+            setReadOnly(true);
+        }
+
+        updateTimestamp();
+        setSavePointIncludingDocumentSwap();
+    }
+
+    // The file changed again while it was being read
+    if (reloadPending) {
+        reloadPending = false;
+        reload();
+    }
+}
+
+void ScintillaNext::setFollowing(bool follow)
+{
+    qInfo(Q_FUNC_INFO);
+
+    if (following == follow) {
+        return;
+    }
+
+    following = follow;
+
+    // New data is picked up when the file change monitor reports the file was modified
+    if (following) {
+        // Jump to the end so new data stays in view
+        documentEnd();
+    }
+
+    emit followingChanged(following);
+}
+
+bool ScintillaNext::appendFromDisk()
+{
+    // Only possible if the buffer is still exactly what was read, and the bytes on disk are the bytes in the buffer
+    if (!isSavedToDisk() || !fileEncoding.isUtf8() || diskOffset < 0) {
+        return false;
+    }
+
+    QFile file(fileInfo.canonicalFilePath());
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 size = file.size();
+
+    // Rotated logs are replaced by a new file, and truncated ones shrink
+    if (size < diskOffset || fileIdentity(file.fileName()) != diskIdentity) {
+        qInfo("File was truncated or replaced, doing a full reload");
+        return false;
+    }
+
+    // Rewriting a file in place keeps it the same file and it may not shrink, so make sure the end of what was
+    // read before is still there
+    const qint64 checkLength = qMin<qint64>(APPEND_CHECK_SIZE, qMin<qint64>(diskOffset, length()));
+
+    if (!file.seek(diskOffset - checkLength) || file.read(checkLength) != textRangeFull(length() - checkLength, length())) {
+        qInfo("File was rewritten, doing a full reload");
+
+        // Nothing of the old text is likely to line up with the new, so diffing them is a waste
+        file.close();
+        reloadFully();
+        return true;
+    }
+
+    if (!file.seek(diskOffset)) {
+        return false;
+    }
+
+    qInfo("Appending %lld bytes from disk", size - diskOffset);
+
+    const bool caretAtEnd = currentPos() == length() && anchor() == length();
+    const bool wasReadOnly = readOnly();
+
+    setReadOnly(false);
+    setUndoCollection(false);
+
+    QByteArray chunk;
+    while (!file.atEnd()) {
+        chunk = file.read(APPEND_CHUNK_SIZE);
+
+        if (chunk.isEmpty()) {
+            break;
+        }
+
+        appendText(chunk.size(), chunk.constData());
+    }
+
+    setUndoCollection(true);
+    setReadOnly(wasReadOnly);
+
+    diskOffset = file.pos();
+
+    updateTimestamp();
+    setSavePointIncludingDocumentSwap();
+
+    if (caretAtEnd) {
+        documentEnd();
+    }
+
+    return true;
+}
+
+bool ScintillaNext::canSearchLiterally(int flags, const QByteArray &text, sptr_t page)
+{
+    // Regular expressions and word starts are left to Scintilla
+    if (text.isEmpty() || (flags & (SCFIND_REGEXP | SCFIND_WORDSTART))) {
+        return false;
+    }
+
+    // Single byte code pages fold case based on the character set, so only UTF-8 is folded here
+    if (!(flags & SCFIND_MATCHCASE)) {
+        return page == SC_CP_UTF8;
+    }
+
+    if (page == 0) {
+        return true;
+    }
+
+    // A UTF-8 match can't start in the middle of a character unless the text itself does. Matching bytes
+    // in other multi-byte code pages doesn't work since their trail bytes can look like lead bytes.
+    return page == SC_CP_UTF8 && (static_cast<unsigned char>(text[0]) & 0xC0) != 0x80;
+}
+
+Sci_Position ScintillaNext::findLiteral(Sci_Position start, Sci_Position end, const QByteArray &text, bool matchCase, Sci_Position *matchLength)
+{
+    if (end <= start) {
+        return INVALID_POSITION;
+    }
+
+    const auto search = [&](const char *data, qint64 dataLength, qint64 *found) {
+        if (matchCase) {
+            *found = text.size();
+            return LiteralSearch::indexOf(data, dataLength, text.constData(), text.size());
+        }
+
+        return foldedSearch.indexIn(data, dataLength, found);
+    };
+
+    // When ignoring case some characters fold to fewer bytes, so a match can be longer than the text
+    const qint64 longest = matchCase ? text.size() : foldedSearch.maximumMatchLength();
+
+    // The document is a gap buffer. Rather than moving the gap, the text on either side of it is searched
+    // separately, and the few bytes spanning the gap are copied out to check for a match across it.
+    const Sci_Position gap = gapPosition();
+    qint64 found = 0;
+
+    if (start < gap) {
+        const Sci_Position beforeEnd = qMin<Sci_Position>(end, gap);
+        const char *before = reinterpret_cast<const char *>(rangePointer(start, beforeEnd - start));
+        const qint64 i = search(before, beforeEnd - start, &found);
+        Sci_Position pos = INVALID_POSITION;
+
+        if (i != -1) {
+            pos = start + i;
+            *matchLength = found;
+        }
+
+        const Sci_Position spanStart = qMax<Sci_Position>(start, gap - longest + 1);
+        const Sci_Position spanEnd = qMin<Sci_Position>(end, gap + longest - 1);
+
+        // Only a match that starts before the gap and before the one already found matters
+        if (spanEnd > gap && (pos == INVALID_POSITION || pos > spanStart)) {
+            const QByteArray span = textRangeFull(spanStart, spanEnd);
+            const qint64 j = search(span.constData(), span.size(), &found);
+
+            if (j != -1 && spanStart + j < gap && (pos == INVALID_POSITION || spanStart + j < pos)) {
+                pos = spanStart + j;
+                *matchLength = found;
+            }
+        }
+
+        if (pos != INVALID_POSITION) {
+            return pos;
+        }
+    }
+
+    const Sci_Position afterStart = qMax<Sci_Position>(start, gap);
+
+    if (afterStart < end) {
+        const char *after = reinterpret_cast<const char *>(rangePointer(afterStart, end - afterStart));
+        const qint64 i = search(after, end - afterStart, &found);
+
+        if (i != -1) {
+            *matchLength = found;
+            return afterStart + i;
+        }
+    }
+
+    return INVALID_POSITION;
+}
+
+void ScintillaNext::updateDiskState(qint64 offset)
+{
+    diskOffset = offset;
+    diskIdentity = fileIdentity(fileInfo.filePath());
 }
 
 QFileDevice::FileError ScintillaNext::saveAs(const QString &newFilePath)
 {
     bool isRenamed = bufferType == ScintillaNext::New || fileInfo.canonicalFilePath() != newFilePath;
 
+    waitForLoad();
+    waitForSave();
+
     emit aboutToSave();
 
-    QFileDevice::FileError saveSuccessful = writeToDisk(QByteArray::fromRawData((char*)characterPointer(), textLength()), newFilePath);
+    QFileDevice::FileError saveSuccessful = writeToDisk(newFilePath);
 
     if (saveSuccessful == QFileDevice::NoError) {
         setFileInfo(newFilePath);
-        setSavePoint();
+        updateDiskState(QFileInfo(fileInfo.filePath()).size());
+        setSavePointIncludingDocumentSwap();
 
         // If this was a temporary file, make sure it is not any more
         setTemporary(false);
@@ -327,7 +708,83 @@ QFileDevice::FileError ScintillaNext::saveAs(const QString &newFilePath)
 
 QFileDevice::FileError ScintillaNext::saveCopyAs(const QString &filePath)
 {
-    return writeToDisk(QByteArray::fromRawData((char*)characterPointer(), textLength()), filePath);
+    waitForLoad();
+
+    return writeToDisk(filePath);
+}
+
+void ScintillaNext::saveInBackground()
+{
+    qInfo(Q_FUNC_INFO);
+
+    Q_ASSERT(isFile());
+
+    waitForLoad();
+    waitForReload();
+
+    // Paged files can't be edited so there is nothing to write in the background
+    if (PagedFileView::forEditor(this)) {
+        save();
+        return;
+    }
+
+    // Only one write to the file at a time
+    waitForSave();
+
+    emit aboutToSave();
+
+    savingModificationCount = modificationCount;
+
+    fileSaver = new FileSaver(this, fileInfo.filePath(), snapshot(), fileEncoding);
+    connect(fileSaver, &FileSaver::finished, this, &ScintillaNext::backgroundSaveFinished);
+    fileSaver->start();
+}
+
+FileSaver *ScintillaNext::saveCopyInBackground(const QString &filePath, const FileEncoding &encoding)
+{
+    waitForLoad();
+
+    FileSaver *saver = new FileSaver(this, filePath, snapshot(), encoding);
+    saver->start();
+
+    return saver;
+}
+
+void ScintillaNext::waitForSave()
+{
+    if (fileSaver) {
+        fileSaver->waitForFinished();
+    }
+}
+
+void ScintillaNext::backgroundSaveFinished(QFileDevice::FileError error)
+{
+    qInfo(Q_FUNC_INFO);
+
+    FileSaver *saver = fileSaver;
+    fileSaver.clear();
+    saver->deleteLater();
+
+    if (error == QFileDevice::NoError) {
+        updateTimestamp();
+
+        // Anything changed during the write still needs to be saved
+        if (modificationCount == savingModificationCount) {
+            updateDiskState(QFileInfo(fileInfo.filePath()).size());
+            setSavePointIncludingDocumentSwap();
+        }
+        else {
+            // The buffer no longer matches what is on disk
+            diskOffset = -1;
+        }
+
+        // If this was a temporary file, make sure it is not any more
+        setTemporary(false);
+
+        emit saved();
+    }
+
+    emit saveFinished(error);
 }
 
 bool ScintillaNext::rename(const QString &newFilePath)
@@ -342,7 +799,7 @@ bool ScintillaNext::rename(const QString &newFilePath)
 
         // Everything worked fine, so update the buffer's info
         setFileInfo(newFilePath);
-        setSavePoint();
+        setSavePointIncludingDocumentSwap();
 
         // If this was a temporary file, make sure it is not any more
         setTemporary(false);
@@ -374,8 +831,8 @@ ScintillaNext::FileStateChange ScintillaNext::checkFileForStateChange()
             return FileStateChange::Deleted;
         }
 
-        // See if the timestamp changed
-        if (modifiedTime != fileTimestamp()) {
+        // See if the timestamp changed, ignoring it while the file is being written
+        if (!isSaving() && modifiedTime != fileTimestamp()) {
             return FileStateChange::Modified;
         }
         else {
@@ -451,18 +908,16 @@ void ScintillaNext::dropEvent(QDropEvent *event)
     ScintillaEdit::dropEvent(event);
 }
 
-bool ScintillaNext::readFromDisk(QFile &file)
+void ScintillaNext::showEvent(QShowEvent *event)
 {
-    if (!file.exists()) {
-        qWarning("Cannot read \"%s\": doesn't exist", qUtf8Printable(file.fileName()));
-        return false;
-    }
+    // Only the visible tab of each dock area gets shown, so this is when a deferred file is actually needed
+    ensureLoaded();
 
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning("QFile::open() failed when opening \"%s\" - error code %d: %s", qUtf8Printable(file.fileName()), file.error(), qUtf8Printable(file.errorString()));
-        return false;
-    }
+    ScintillaEdit::showEvent(event);
+}
 
+bool ScintillaNext::readFromDisk(QFile &file)
+{
     // TODO: figure out what to do if "size" is too big
     allocate(file.size());
 
@@ -472,92 +927,359 @@ bool ScintillaNext::readFromDisk(QFile &file)
     // TODO disable notifications
     // modEventMask(SC_MOD_NONE)?
 
-    QByteArray chunk;
-    qint64 bytesRead;
-    QTextCodec *codec = Q_NULLPTR;
-    QTextCodec::ConverterState state;
+    LoadAnalyzer analyzer;
+    FileReader reader(file);
+    reader.setAnalyzer(&analyzer);
+    const bool readSuccessful = reader.read([=](const char *data, qint64 length) {
+        appendText(length, data);
+        return status() == SC_STATUS_OK;
+    });
+
+    // Restore it back
+    this->blockSignals(false);
+    setUndoCollection(true);
+    // modEventMask(SC_MODEVENTMASKALL)?
+
+    if (status() != SC_STATUS_OK) {
+        qWarning("something bad happened in document->add_data() %ld", status());
+        return false;
+    }
+
+    if (!readSuccessful) {
+        return false;
+    }
 
-    bool first_read = true;
-    do {
-        // Try to read as much as possible
-        chunk.resize(CHUNK_SIZE);
-        bytesRead = file.read(chunk.data(), CHUNK_SIZE);
-        chunk.resize(bytesRead);
+    fileAnalysis = analyzer.finish();
+    applyFileAnalysis();
+    setEncoding(reader.getEncoding());
+    updateDiskState(reader.getBytesRead());
 
-        qDebug("Read %lld bytes", bytesRead);
+    if (!QFileInfo(file).isWritable()) {
+        qInfo("Setting file as read-only");
+        setReadOnly(true);
+    }
 
-        // TODO: this needs moved out of here. Would make much more sense to have a class (or classes)
-        // responsible for handling low level situations like this to do things like:
-        // - determine encoding
-        // - determine space vs tabs
-        // - determine indentation size
+    return true;
+}
 
-        if (first_read) {
-            first_read = false;
+void ScintillaNext::loadInBackground(const QString &filePath, int documentOptions, QThreadPool *pool)
+{
+    qInfo(Q_FUNC_INFO);
 
-            // Search for a BOM mark
-            codec = QTextCodec::codecForUtfText(chunk, Q_NULLPTR);
+    Q_ASSERT(fileLoader.isNull());
 
-            if (codec != Q_NULLPTR) {
-                qDebug("BOM mark found");
-            }
-            else {
-                qDebug("BOM mark not found, using uchardet");
-
-                // Limit decoding to the first 64 kilobytes
-                int detectionSize = qMin(chunk.size(), 64 * 1024);
-
-                // Use uchardet to try and detect file encoding since no BOM was found
-                uchardet_t encodingDetector = uchardet_new();
-                if (uchardet_handle_data(encodingDetector, chunk.data(), detectionSize) == 0) {
-                    uchardet_data_end(encodingDetector);
-
-                    qDebug("uchardet detected encoding as: '%s'", uchardet_get_charset(encodingDetector));
-                    codec = QTextCodec::codecForName(uchardet_get_charset(encodingDetector));
-                }
-                else {
-                    qDebug("uchardet failure");
-                }
-                uchardet_delete(encodingDetector);
-            }
+    fileLoader = new FileLoader(this, filePath, documentOptions);
 
-            qDebug("Using codec: '%s'", codec ? codec->name().constData() : "");
-        }
+    FileLoadingBar *loadingBar = new FileLoadingBar(this);
+    connect(fileLoader, &FileLoader::progressChanged, loadingBar, &FileLoadingBar::setProgress);
+    connect(fileLoader, &FileLoader::finished, loadingBar, &FileLoadingBar::deleteLater);
+    connect(loadingBar, &FileLoadingBar::cancelRequested, fileLoader, &FileLoader::cancel);
 
-        if (codec) {
-            const QByteArray utf8_data = codec->toUnicode(chunk.constData(), chunk.size(), &state).toUtf8();
-            appendText(utf8_data.size(), utf8_data.constData());
-        }
-        else {
-            appendText(chunk.size(), chunk.constData());
+    connect(fileLoader, &FileLoader::finished, this, &ScintillaNext::backgroundLoadFinished);
+
+    // The placeholder document will be thrown away, so don't allow any edits to it
+    setReadOnly(true);
+
+    loadingBar->show();
+    fileLoader->start(pool ? pool : QThreadPool::globalInstance());
+}
+
+void ScintillaNext::deferLoad(const QString &filePath, int documentOptions)
+{
+    qInfo(Q_FUNC_INFO);
+
+    Q_ASSERT(fileLoader.isNull());
+
+    deferredFilePath = filePath;
+    deferredDocumentOptions = documentOptions;
+}
+
+void ScintillaNext::ensureLoaded()
+{
+    if (!isLoadDeferred()) {
+        return;
+    }
+
+    const QString filePath = deferredFilePath;
+    deferredFilePath.clear();
+
+    loadInBackground(filePath, deferredDocumentOptions);
+}
+
+void ScintillaNext::prefetch(QThreadPool *pool, ScintillaNext *previous)
+{
+    if (!isLoadDeferred()) {
+        return;
+    }
+
+    const QString filePath = deferredFilePath;
+    deferredFilePath.clear();
+
+    loadInBackground(filePath, deferredDocumentOptions, pool);
+
+    if (previous && previous->fileLoader) {
+        fileLoader->finishAfter(previous->fileLoader);
+    }
+}
+
+void ScintillaNext::waitForLoad()
+{
+    ensureLoaded();
+
+    if (fileLoader) {
+        fileLoader->waitForFinished();
+    }
+}
+
+void ScintillaNext::backgroundLoadFinished(bool success)
+{
+    qInfo(Q_FUNC_INFO);
+
+    FileLoader *loader = fileLoader;
+    fileLoader.clear();
+
+    if (success) {
+        fileAnalysis = loader->getAnalysis();
+
+        attachDocument(loader->takeDocument());
+        applyFileAnalysis();
+        setEncoding(loader->getEncoding());
+        updateDiskState(loader->getBytesRead());
+        updateTimestamp();
+
+        if (!QFileInfo(loader->getFilePath()).isWritable()) {
+            qInfo("Setting file as read-only");
+            setReadOnly(true);
         }
-    } while (!file.atEnd() && status() == SC_STATUS_OK);
+    }
+    else {
+        qWarning("Failed to load \"%s\"", qUtf8Printable(loader->getFilePath()));
+    }
 
-    file.close();
+    loader->deleteLater();
 
-    // Restore it back
-    this->blockSignals(false);
+    // There is nothing to show the user if it was canceled or failed
+    if (!success) {
+        reloadPending = false;
+        close();
+    }
+
+    emit loadFinished(success);
+
+    // The file changed while it was being read
+    if (reloadPending) {
+        reloadPending = false;
+        reload();
+    }
+}
+
+void ScintillaNext::attachDocument(void *document)
+{
+    // These are stored on the document rather than the view, and may have been configured (e.g. by
+    // EditorConfig) before the file finished loading
+    const int eolMode = eOLMode();
+    const bool tabs = useTabs();
+    const int tabSize = tabWidth();
+    const int indentSize = indent();
+
+    // The editor takes its own reference to the document so the loader's reference can be dropped
+    setDocPointer(reinterpret_cast<sptr_t>(document));
+    releaseDocument(reinterpret_cast<sptr_t>(document));
+
+    setEOLMode(eolMode);
+    setUseTabs(tabs);
+    setTabWidth(tabSize);
+    setIndent(indentSize);
+
+    // Loaders are created with undo collection disabled
     setUndoCollection(true);
-    // modEventMask(SC_MODEVENTMASKALL)?
+    emptyUndoBuffer();
+    setSavePointIncludingDocumentSwap();
+}
 
-    if (status() != SC_STATUS_OK) {
-        qWarning("something bad happened in document->add_data() %ld", status());
+bool ScintillaNext::setDocumentOptions(int documentOptions)
+{
+    if (this->documentOptions() == documentOptions) {
+        return true;
+    }
+
+    qInfo(Q_FUNC_INFO);
+
+    waitForLoad();
+
+    const sptr_t length = textLength();
+    Scintilla::ILoader *loader = reinterpret_cast<Scintilla::ILoader *>(createLoader(length, documentOptions));
+
+    if (loader == Q_NULLPTR) {
+        qWarning("Unable to create a document with options %d", documentOptions);
         return false;
     }
 
-    if (bytesRead == -1) {
-        qWarning("Something bad happened when reading disk %d %s", file.error(), qUtf8Printable(file.errorString()));
+    // Copy each side of the gap buffer directly so the text isn't duplicated more than needed
+    const sptr_t gap = qBound<sptr_t>(0, gapPosition(), length);
+    const char *beforeGap = reinterpret_cast<const char *>(rangePointer(0, gap));
+    const char *afterGap = reinterpret_cast<const char *>(rangePointer(gap, length - gap));
+
+    if (loader->AddData(beforeGap, gap) != SC_STATUS_OK || loader->AddData(afterGap, length - gap) != SC_STATUS_OK) {
+        qWarning("Unable to copy the text into the new document");
+        loader->Release();
         return false;
     }
 
-    if (!QFileInfo(file).isWritable()) {
-        qInfo("Setting file as read-only");
-        setReadOnly(true);
+    if (canUndo() || canRedo()) {
+        qWarning("Undo history is lost when changing document options");
     }
 
+    const bool modified = isModifiedIncludingDocumentSwap();
+    const sptr_t caret = currentPos();
+    const sptr_t anchorPosition = anchor();
+    const sptr_t topLine = firstVisibleLine();
+
+    attachDocument(loader->ConvertToDocument());
+
+    // New documents start at the save point, so remember the text still differs from what is on disk
+    if (modified) {
+        modifiedBeforeNewDocument = true;
+        emit savePointChanged(true);
+    }
+
+    setSelection(caret, anchorPosition);
+    setFirstVisibleLine(topLine);
+
     return true;
 }
 
+void ScintillaNext::setSavePointIncludingDocumentSwap()
+{
+    modifiedBeforeNewDocument = false;
+
+    setSavePoint();
+}
+
+void ScintillaNext::setEncoding(const FileEncoding &encoding)
+{
+    fileEncoding = encoding;
+
+    emit encodingChanged();
+}
+
+void ScintillaNext::applyFileAnalysis()
+{
+    qInfo("File analysis: longest line %lld, EOL mode %d%s, tabs %d, indent %d%s",
+          fileAnalysis.longestLine, fileAnalysis.eolMode,
+          fileAnalysis.hasMixedEols ? " (mixed)" : "", fileAnalysis.useTabs, fileAnalysis.indentSize,
+          fileAnalysis.isBinary ? ", binary" : "");
+
+    // Anything explicitly configured (e.g. by EditorConfig) takes priority over what was detected.
+    // The dynamic properties also keep the language defaults from overriding the detected values.
+    auto isDetectable = [=](const char *name) {
+        const QVariant value = QObject::property(name);
+        return !value.isValid() || value.toString() == QStringLiteral("FileAnalysis");
+    };
+
+    if (fileAnalysis.eolMode != -1 && isDetectable("nn_skip_eolmode")) {
+        setEOLMode(fileAnalysis.eolMode);
+        QObject::setProperty("nn_skip_eolmode", "FileAnalysis");
+    }
+
+    if (fileAnalysis.useTabs != -1 && isDetectable("nn_skip_usetabs")) {
+        setUseTabs(fileAnalysis.useTabs == 1);
+        QObject::setProperty("nn_skip_usetabs", "FileAnalysis");
+    }
+
+    if (fileAnalysis.indentSize > 0 && isDetectable("nn_skip_indent")) {
+        setIndent(fileAnalysis.indentSize);
+        QObject::setProperty("nn_skip_indent", "FileAnalysis");
+    }
+}
+
+QFileDevice::FileError ScintillaNext::writeToDisk(const QString &path)
+{
+    qInfo(Q_FUNC_INFO);
+
+    // The editor only has part of a paged file, so the file itself gets copied instead
+    if (PagedFileView::forEditor(this)) {
+        return copyFileTo(path);
+    }
+
+    QSaveFile file(path);
+    file.setDirectWriteFallback(true);
+
+    if (file.open(QIODevice::WriteOnly)) {
+        // Write each side of the gap buffer separately. characterPointer() would force Scintilla
+        // to move the gap to the end, which is a copy of everything after it.
+        const sptr_t length = textLength();
+        const sptr_t gap = qBound<sptr_t>(0, gapPosition(), length);
+
+        const char *beforeGap = reinterpret_cast<const char *>(rangePointer(0, gap));
+        const char *afterGap = reinterpret_cast<const char *>(rangePointer(gap, length - gap));
+
+        EncodingWriter writer(file, fileEncoding);
+
+        if (writer.write(beforeGap, gap) && writer.write(afterGap, length - gap) && writer.finish()) {
+            if (file.commit()) {
+                return QFileDevice::NoError;
+            }
+        }
+    }
+
+    // If it got to this point there was an error
+    qWarning("writeToDisk() failure code %d: %s", file.error(), qPrintable(file.errorString()));
+    return file.error();
+}
+
+QFileDevice::FileError ScintillaNext::copyFileTo(const QString &path)
+{
+    // Read-only files can't have changed, so writing it over itself does nothing
+    if (QFileInfo(path) == fileInfo) {
+        return QFileDevice::NoError;
+    }
+
+    QFile source(fileInfo.filePath());
+    QSaveFile file(path);
+    file.setDirectWriteFallback(true);
+
+    if (source.open(QIODevice::ReadOnly) && file.open(QIODevice::WriteOnly)) {
+        QByteArray chunk;
+        bool writeSuccessful = true;
+
+        while (!source.atEnd() && writeSuccessful) {
+            chunk = source.read(1024 * 1024 * 4);
+            writeSuccessful = !chunk.isEmpty() && file.write(chunk) == chunk.size();
+        }
+
+        if (writeSuccessful && file.commit()) {
+            return QFileDevice::NoError;
+        }
+    }
+
+    qWarning("copyFileTo() failure code %d: %s", file.error(), qPrintable(file.errorString()));
+    return file.error() != QFileDevice::NoError ? file.error() : QFileDevice::CopyError;
+}
+
+QVector<QByteArray> ScintillaNext::snapshot()
+{
+    // Copy the text from either side of the gap so the gap doesn't get moved. Using several smaller
+    // pieces avoids one huge allocation and the QByteArray size limit.
+    QVector<QByteArray> pieces;
+
+    const sptr_t length = textLength();
+    const sptr_t gap = qBound<sptr_t>(0, gapPosition(), length);
+
+    const char *beforeGap = reinterpret_cast<const char *>(rangePointer(0, gap));
+    const char *afterGap = reinterpret_cast<const char *>(rangePointer(gap, length - gap));
+
+    for (sptr_t i = 0; i < gap; i += SNAPSHOT_CHUNK_SIZE) {
+        pieces.append(QByteArray(beforeGap + i, static_cast<int>(qMin<sptr_t>(SNAPSHOT_CHUNK_SIZE, gap - i))));
+    }
+
+    for (sptr_t i = 0; i < length - gap; i += SNAPSHOT_CHUNK_SIZE) {
+        pieces.append(QByteArray(afterGap + i, static_cast<int>(qMin<sptr_t>(SNAPSHOT_CHUNK_SIZE, length - gap - i))));
+    }
+
+    return pieces;
+}
+
 QDateTime ScintillaNext::fileTimestamp()
 {
     Q_ASSERT(bufferType != ScintillaNext::New);
@@ -577,6 +1299,9 @@ void ScintillaNext::setFileInfo(const QString &filePath)
     fileInfo.setFile(filePath);
     fileInfo.makeAbsolute();
 
+    // Whatever was read before doesn't correspond to this file
+    diskOffset = -1;
+
     Q_ASSERT(fileInfo.exists());
 
     name = fileInfo.fileName();
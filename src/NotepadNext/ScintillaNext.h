@@ -20,22 +20,30 @@
 #ifndef SCINTILLANEXT_H
 #define SCINTILLANEXT_H
 
+#include "FileReader.h"
+#include "LiteralSearch.h"
+#include "LoadAnalyzer.h"
 #include "RangeAllocator.h"
 #include "ScintillaEdit.h"
 
 #include <QDateTime>
 #include <QFile>
 #include <QFileInfo>
+#include <QPointer>
 
 
-
+class FileLoader;
+class QThreadPool;
+class FileReloader;
+class FileSaver;
 
 class ScintillaNext : public ScintillaEdit
 {
     Q_OBJECT
 
 public:
-    static bool isRangeValid(const Sci_CharacterRange &range)
+    // Positions are 64-bit so documents over 2 GB are not truncated
+    static bool isRangeValid(const Sci_CharacterRangeFull &range)
     {
         return range.cpMin != INVALID_POSITION && range.cpMax != INVALID_POSITION;
     }
@@ -43,7 +51,7 @@ public:
     explicit ScintillaNext(QString name, QWidget *parent = Q_NULLPTR);
     virtual ~ScintillaNext();
 
-    static ScintillaNext *fromFile(const QString &filePath, bool tryToCreate=false);
+    static ScintillaNext *fromFile(const QString &filePath, bool tryToCreate=false, int documentOptions=SC_DOCUMENTOPTION_DEFAULT);
 
     int allocateIndicator(const QString &name);
 
@@ -51,21 +59,32 @@ public:
     void forEachMatch(const QString &text, Func callback) { forEachMatch(text.toUtf8(), callback); }
 
     template<typename Func>
-    void forEachMatch(const QByteArray &byteArray, Func callback) { forEachMatchInRange(byteArray, callback, {0, (Sci_PositionCR)length()}); }
+    void forEachMatch(const QByteArray &byteArray, Func callback) { forEachMatchInRange(byteArray, callback, {0, length()}); }
 
     template<typename Func>
-    void forEachMatchInRange(const QByteArray &byteArray, Func callback, Sci_CharacterRange range);
+    void forEachMatchInRange(const QByteArray &byteArray, Func callback, Sci_CharacterRangeFull range);
 
     template<typename Func>
     void forEachLineInSelection(int selection, Func callback);
 
-    void goToRange(const Sci_CharacterRange &range);
+    void goToRange(const Sci_CharacterRangeFull &range);
+
+    // Same as get_text_range() but not limited to 32-bit positions
+    QByteArray textRangeFull(Sci_Position start, Sci_Position end);
+
+    // Same as SCI_FINDTEXTFULL, except forward plain text searches are done directly on the document's
+    // memory with LiteralSearch, including case insensitive ones in UTF-8 documents. Anything it can't
+    // handle is passed on to Scintilla.
+    Sci_Position findTextFull(int flags, Sci_TextToFindFull *ttf);
+
+    // Whether findTextFull() can search for the text itself in a document using the given code page
+    static bool canSearchLiterally(int flags, const QByteArray &text, sptr_t page);
 
     QByteArray eolString() const;
 
-    bool lineIsEmpty(int line);
+    bool lineIsEmpty(Sci_Position line);
 
-    void deleteLine(int line);
+    void deleteLine(Sci_Position line);
 
     void cutAllowLine();
 
@@ -104,6 +123,42 @@ public:
     bool isTemporary() const { return temporary; }
     void setTemporary(bool temp);
 
+    void loadInBackground(const QString &filePath, int documentOptions=SC_DOCUMENTOPTION_DEFAULT, QThreadPool *pool=Q_NULLPTR);
+    bool isLoading() const { return !fileLoader.isNull() || isLoadDeferred(); }
+    void waitForLoad();
+
+    // The file is only read once it is actually needed, e.g. when a restored session tab is first shown
+    void deferLoad(const QString &filePath, int documentOptions=SC_DOCUMENTOPTION_DEFAULT);
+    bool isLoadDeferred() const { return !deferredFilePath.isEmpty(); }
+    QString getDeferredFilePath() const { return deferredFilePath; }
+    int getDeferredDocumentOptions() const { return deferredDocumentOptions; }
+    void ensureLoaded();
+
+    // Starts reading a placeholder on the pool. The document isn't attached until the previous editor's is, so a
+    // batch of placeholders fills in in tab order.
+    void prefetch(QThreadPool *pool, ScintillaNext *previous);
+
+    // Details about the file gathered while it was read from disk. Use this rather than scanning the document again.
+    const FileAnalysis &getFileAnalysis() const { return fileAnalysis; }
+    // After converting the line endings they are all the same again
+    void clearMixedEols() { fileAnalysis.hasMixedEols = false; }
+
+    // Goes up every time text is inserted or deleted, so it can tell if the buffer changed since some earlier point
+    quint64 getModificationCount() const { return modificationCount; }
+
+    // Scintilla can't change the options of an existing document, so this moves the text into a new one.
+    // Undo history and markers are lost.
+    bool setDocumentOptions(int documentOptions);
+
+    // Like modify() and setSavePoint(), but a buffer that setDocumentOptions() moved into a new document still
+    // counts as modified, even though the new document starts out at its save point
+    bool isModifiedIncludingDocumentSwap() const { return modify() || modifiedBeforeNewDocument; }
+    void setSavePointIncludingDocumentSwap();
+
+    // The encoding the file is written back out as
+    FileEncoding getEncoding() const { return fileEncoding; }
+    void setEncoding(const FileEncoding &encoding);
+
     void setFoldMarkers(const QString &type);
 
     QString languageName;
@@ -118,6 +173,20 @@ public slots:
     void reload();
     QFileDevice::FileError saveAs(const QString &newFilePath);
     QFileDevice::FileError saveCopyAs(const QString &filePath);
+
+    // These write a snapshot of the buffer on a worker thread and return immediately
+    void saveInBackground();
+    FileSaver *saveCopyInBackground(const QString &filePath, const FileEncoding &encoding);
+    bool isSaving() const { return !fileSaver.isNull(); }
+    void waitForSave();
+
+    // Reloading only applies what changed on disk, as a single undo action
+    bool isReloading() const { return !fileReloader.isNull(); }
+    void waitForReload();
+
+    // Following a file keeps reading new data as it is appended, e.g. log files
+    bool isFollowing() const { return following; }
+    void setFollowing(bool follow);
     bool rename(const QString &newFilePath);
     ScintillaNext::FileStateChange checkFileForStateChange();
     bool moveToTrash();
@@ -131,12 +200,17 @@ signals:
     void saved();
     void closed();
     void renamed();
+    void loadFinished(bool success);
+    void saveFinished(QFileDevice::FileError error);
 
     void lexerChanged();
+    void encodingChanged();
+    void followingChanged(bool following);
 
 protected:
     void dragEnterEvent(QDragEnterEvent *event) override;
     void dropEvent(QDropEvent *event) override;
+    void showEvent(QShowEvent *event) override;
 
 private:
     QString name;
@@ -147,7 +221,43 @@ private:
 
     bool temporary = false; // Temporary file loaded from a session. It can either be a 'New' file or actual 'File'
 
+    QPointer<FileLoader> fileLoader;
+    QString deferredFilePath;
+    int deferredDocumentOptions = SC_DOCUMENTOPTION_DEFAULT;
+    FileAnalysis fileAnalysis;
+    FileEncoding fileEncoding;
+
+    QPointer<FileSaver> fileSaver;
+    quint64 modificationCount = 0;
+    bool modifiedBeforeNewDocument = false;
+    quint64 savingModificationCount = 0;
+
+    QPointer<FileReloader> fileReloader;
+    quint64 reloadModificationCount = 0;
+    bool reloadPending = false;
+
+    bool following = false;
+
+    // Kept between searches since building it is more work than a short search
+    LiteralSearch::FoldedSearch foldedSearch;
+
+    // How much of the file is in the buffer, and which file it was, -1 if the buffer doesn't match the file
+    qint64 diskOffset = -1;
+    quint64 diskIdentity = 0;
+
     bool readFromDisk(QFile &file);
+    void backgroundLoadFinished(bool success);
+    void attachDocument(void *document);
+    void applyFileAnalysis();
+    QFileDevice::FileError writeToDisk(const QString &path);
+    QFileDevice::FileError copyFileTo(const QString &path);
+    QVector<QByteArray> snapshot();
+    void backgroundSaveFinished(QFileDevice::FileError error);
+    void reloadFully();
+    void backgroundReloadFinished(bool success);
+    bool appendFromDisk();
+    Sci_Position findLiteral(Sci_Position start, Sci_Position end, const QByteArray &text, bool matchCase, Sci_Position *matchLength);
+    void updateDiskState(qint64 offset);
     QDateTime fileTimestamp();
     void updateTimestamp();
 
@@ -156,22 +266,22 @@ private:
 template<typename Func>
 void ScintillaNext::forEachLineInSelection(int selection, Func callback)
 {
-    int lineStart = lineFromPosition(selectionNStart(selection));
-    int lineEnd = lineFromPosition(selectionNEnd(selection));
+    const Sci_Position lineStart = lineFromPosition(selectionNStart(selection));
+    const Sci_Position lineEnd = lineFromPosition(selectionNEnd(selection));
 
-    for (int curLine = lineStart; curLine <= lineEnd; ++curLine) {
+    for (Sci_Position curLine = lineStart; curLine <= lineEnd; ++curLine) {
         callback(curLine);
     }
 }
 
 // Stick this in the header file...because C++, that's why
 template<typename Func>
-void ScintillaNext::forEachMatchInRange(const QByteArray &text, Func callback, Sci_CharacterRange range)
+void ScintillaNext::forEachMatchInRange(const QByteArray &text, Func callback, Sci_CharacterRangeFull range)
 {
-    Sci_TextToFind ttf {range, text.constData(), {-1, -1}};
+    Sci_TextToFindFull ttf {range, text.constData(), {-1, -1}};
     int flags = searchFlags();
 
-    while (send(SCI_FINDTEXT, flags, reinterpret_cast<sptr_t>(&ttf)) != -1) {
+    while (findTextFull(flags, &ttf) != -1) {
         ttf.chrg.cpMin = callback(ttf.chrgText.cpMin, ttf.chrgText.cpMax);
     }
 }
@@ -42,7 +42,7 @@ void SelectionTracker::restoreSelection()
     editor->setSelection(caret, anchor);
 }
 
-void SelectionTracker::trackInsertion(int pos, int length)
+void SelectionTracker::trackInsertion(Sci_Position pos, Sci_Position length)
 {
     if (caret >= pos) {
         caret += length;
@@ -52,13 +52,13 @@ void SelectionTracker::trackInsertion(int pos, int length)
     }
 }
 
-void SelectionTracker::trackDeletion(int pos, int length)
+void SelectionTracker::trackDeletion(Sci_Position pos, Sci_Position length)
 {
     // Adjust the caret and anchor. Use the min in case they are within the range being deleted
     if (caret > pos) {
-        caret -= qMin(static_cast<int>(caret - pos), length);
+        caret -= qMin(caret - pos, length);
     }
     if (anchor > pos) {
-        anchor -= qMin(static_cast<int>(anchor - pos), length);
+        anchor -= qMin(anchor - pos, length);
     }
 }
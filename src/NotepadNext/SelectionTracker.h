@@ -20,6 +20,8 @@
 #ifndef SELECTIONTRACKER_H
 #define SELECTIONTRACKER_H
 
+#include "Sci_Position.h"
+
 class ScintillaNext;
 
 class SelectionTracker
@@ -28,16 +30,16 @@ public:
     explicit SelectionTracker(ScintillaNext *editor);
     ~SelectionTracker();
 
-    void trackInsertion(int pos, int length);
-    void trackDeletion(int pos, int length);
+    void trackInsertion(Sci_Position pos, Sci_Position length);
+    void trackDeletion(Sci_Position pos, Sci_Position length);
 
 private:
     void saveSelection();
     void restoreSelection();
 
     ScintillaNext *editor;
-    int caret;
-    int anchor;
+    Sci_Position caret;
+    Sci_Position anchor;
 };
 
 #endif // SELECTIONTRACKER_H
@@ -20,13 +20,33 @@
 #include "ScintillaNext.h"
 #include "MainWindow.h"
 #include "SessionManager.h"
+#include "FileSaver.h"
 #include "EditorManager.h"
+#include "BookMarkDecorator.h"
 
+#include <QDataStream>
 #include <QDir>
+#include <QHash>
+#include <QSaveFile>
+#include <QSettings>
 #include <QStandardPaths>
 #include <QUuid>
 
 
+// Each buffer keeps the same session file for as long as it is open, along with the modification count
+// it had when that file was last written, so buffers that haven't changed don't need written again
+static const char *SESSION_FILE_NAME = "nn_session_file_name";
+static const char *SESSION_MODIFICATION_COUNT = "nn_session_modification_count";
+
+// What a tab was restored with, until it has actually been loaded and the view set up
+static const char *SESSION_VIEW_STATE = "nn_session_view_state";
+static const char *SESSION_ENCODING = "nn_session_encoding";
+static const char *SESSION_ENCODING_HAS_BOM = "nn_session_encoding_has_bom";
+
+// "NNSS" followed by a version number, which needs bumped any time the layout changes
+const quint32 SESSION_STORE_MAGIC = 0x4E4E5353;
+const quint32 SESSION_STORE_VERSION = 1;
+
 static QString RandomSessionFileName()
 {
     return QUuid::createUuid().toString(QUuid::WithoutBraces);
@@ -52,9 +72,81 @@ QDir SessionManager::sessionDirectory() const
     return d;
 }
 
-void SessionManager::saveIntoSessionDirectory(ScintillaNext *editor, const QString &sessionFileName) const
+QString SessionManager::sessionStoreFilePath() const
+{
+    // Kept out of the session directory since anything in there that isn't in use gets removed
+    QDir d(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+
+    d.mkpath(".");
+
+    return d.filePath("session.dat");
+}
+
+QString SessionManager::sessionFileNameFor(ScintillaNext *editor) const
+{
+    QString sessionFileName = SessionManager::sessionFileName(editor);
+
+    if (sessionFileName.isEmpty()) {
+        sessionFileName = RandomSessionFileName();
+        setSessionFileName(editor, sessionFileName);
+    }
+
+    return sessionFileName;
+}
+
+QString SessionManager::sessionFileName(const ScintillaNext *editor)
 {
-    editor->saveCopyAs(sessionDirectory().filePath(sessionFileName));
+    return editor->QObject::property(SESSION_FILE_NAME).toString();
+}
+
+void SessionManager::setSessionFileName(ScintillaNext *editor, const QString &sessionFileName)
+{
+    editor->QObject::setProperty(SESSION_FILE_NAME, sessionFileName);
+}
+
+void SessionManager::saveIntoSessionDirectory(ScintillaNext *editor, const QString &sessionFileName)
+{
+    const QString sessionFilePath = sessionDirectory().filePath(sessionFileName);
+
+    usedSessionFileNames.append(sessionFileName);
+
+    // A placeholder hasn't even read its session file yet, so there is nothing new to write
+    if (editor->isLoadDeferred()) {
+        qDebug("  session file \"%s\" not loaded, skipping", qUtf8Printable(sessionFileName));
+        return;
+    }
+
+    const QVariant writtenCount = editor->QObject::property(SESSION_MODIFICATION_COUNT);
+    if (writtenCount.isValid() && writtenCount.toULongLong() == editor->getModificationCount() && QFileInfo::exists(sessionFilePath)) {
+        qDebug("  session file \"%s\" unchanged, skipping", qUtf8Printable(sessionFileName));
+        return;
+    }
+
+    // Session copies are always UTF-8, the original encoding is stored in the settings instead
+    FileSaver *saver = editor->saveCopyInBackground(sessionFilePath, FileEncoding());
+
+    editor->QObject::setProperty(SESSION_MODIFICATION_COUNT, static_cast<qulonglong>(editor->getModificationCount()));
+
+    // Make sure it gets written again next time
+    QObject::connect(saver, &FileSaver::finished, editor, [=](QFileDevice::FileError error) {
+        if (error != QFileDevice::NoError) {
+            editor->QObject::setProperty(SESSION_MODIFICATION_COUNT, QVariant());
+        }
+    });
+
+    pendingSaves.append(saver);
+}
+
+void SessionManager::waitForPendingSaves()
+{
+    for (const QPointer<FileSaver> &saver : qAsConst(pendingSaves)) {
+        if (saver) {
+            saver->waitForFinished();
+            saver->deleteLater();
+        }
+    }
+
+    pendingSaves.clear();
 }
 
 SessionManager::SessionFileType SessionManager::determineType(ScintillaNext *editor) const
@@ -79,6 +171,8 @@ SessionManager::SessionFileType SessionManager::determineType(ScintillaNext *edi
 
 void SessionManager::clear() const
 {
+    QFile::remove(sessionStoreFilePath());
+
     clearSettings();
     clearDirectory();
 }
@@ -93,132 +187,281 @@ void SessionManager::clearSettings() const
 }
 
 void SessionManager::clearDirectory() const
+{
+    removeStaleSessionFiles(QStringList());
+}
+
+void SessionManager::removeStaleSessionFiles(const QStringList &sessionFileNames) const
 {
     QDir d = sessionDirectory();
 
-    for (const QString &f : d.entryList()) {
-        d.remove(f);
+    for (const QString &f : d.entryList(QDir::Files)) {
+        if (!sessionFileNames.contains(f)) {
+            d.remove(f);
+        }
     }
 }
 
+static QDataStream &operator<<(QDataStream &stream, const SessionManager::SessionEntry &entry)
+{
+    stream << static_cast<quint8>(entry.type);
+    stream << entry.filePath << entry.fileName << entry.sessionFileName;
+    stream << entry.encoding << entry.encodingHasBom;
+    stream << entry.viewState;
+
+    return stream;
+}
+
+static QDataStream &operator>>(QDataStream &stream, SessionManager::SessionEntry &entry)
+{
+    quint8 type;
+
+    stream >> type;
+    stream >> entry.filePath >> entry.fileName >> entry.sessionFileName;
+    stream >> entry.encoding >> entry.encodingHasBom;
+    stream >> entry.viewState;
+
+    entry.type = static_cast<SessionManager::SessionFileType>(type);
+
+    return stream;
+}
+
+bool SessionManager::writeSessionStore(const QVector<SessionEntry> &entries, int currentEditorIndex) const
+{
+    // The old session stays in place until the new one has been completely written
+    QSaveFile file(sessionStoreFilePath());
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Unable to write session \"%s\": %s", qUtf8Printable(file.fileName()), qUtf8Printable(file.errorString()));
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    stream << SESSION_STORE_MAGIC << SESSION_STORE_VERSION;
+    stream << static_cast<qint32>(currentEditorIndex);
+    stream << static_cast<quint32>(entries.size());
+
+    for (const SessionEntry &entry : entries) {
+        stream << entry;
+    }
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qWarning("Unable to write session \"%s\": %s", qUtf8Printable(file.fileName()), qUtf8Printable(file.errorString()));
+        return false;
+    }
+
+    return true;
+}
+
+bool SessionManager::readSessionStore(QVector<SessionEntry> &entries, int &currentEditorIndex) const
+{
+    QFile file(sessionStoreFilePath());
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // Read the whole thing in one go, straight out of the mapped file if possible
+    uchar *data = file.size() > 0 ? file.map(0, file.size()) : Q_NULLPTR;
+    const QByteArray contents = data ? QByteArray::fromRawData(reinterpret_cast<const char *>(data), static_cast<int>(file.size())) : file.readAll();
+
+    QDataStream stream(contents);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic;
+    quint32 version;
+    qint32 index;
+    quint32 count;
+
+    stream >> magic >> version >> index >> count;
+
+    bool valid = stream.status() == QDataStream::Ok && magic == SESSION_STORE_MAGIC;
+
+    if (valid && version != SESSION_STORE_VERSION) {
+        qWarning("Unsupported session version %u", version);
+        valid = false;
+    }
+
+    if (valid) {
+        currentEditorIndex = index;
+
+        // Don't trust the count to reserve memory up front, a corrupted file could claim anything
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+            SessionEntry entry;
+            stream >> entry;
+            entries.append(entry);
+        }
+
+        if (stream.status() != QDataStream::Ok) {
+            qWarning("Session \"%s\" is corrupted", qUtf8Printable(file.fileName()));
+            entries.clear();
+            valid = false;
+        }
+    }
+
+    if (data) {
+        file.unmap(data);
+    }
+
+    return valid;
+}
+
+void SessionManager::readLegacySession(QVector<SessionEntry> &entries, int &currentEditorIndex) const
+{
+    QSettings settings;
+
+    settings.beginGroup("CurrentSession");
+
+    currentEditorIndex = settings.value("CurrentEditorIndex").toInt();
+    const int size = settings.beginReadArray("OpenedFiles");
+
+    for (int index = 0; index < size; ++index) {
+        settings.setArrayIndex(index);
+
+        SessionEntry entry;
+        const QString type = settings.value("Type").toString();
+
+        if (type == QStringLiteral("File")) {
+            entry.type = SessionManager::SavedFile;
+        }
+        else if (type == QStringLiteral("UnsavedFile")) {
+            entry.type = SessionManager::UnsavedFile;
+        }
+        else if (type == QStringLiteral("Temp")) {
+            entry.type = SessionManager::TempFile;
+        }
+
+        entry.filePath = settings.value("FilePath").toString();
+        entry.fileName = settings.value("FileName").toString();
+        entry.sessionFileName = settings.value("SessionFileName").toString();
+        entry.encoding = settings.value("Encoding").toString().toLatin1();
+        entry.encodingHasBom = settings.value("EncodingHasBom").toBool();
+
+        // Only the first visible line and the caret were kept back then
+        const qint64 position = settings.value("CurrentPosition").toLongLong();
+
+        QDataStream stream(&entry.viewState, QIODevice::WriteOnly);
+        stream << static_cast<qint64>(settings.value("FirstVisibleLine").toLongLong() - 1);
+        stream << static_cast<qint32>(1) << static_cast<qint32>(0) << position << position;
+        stream << QVector<qint64>() << QVector<qint64>();
+
+        entries.append(entry);
+    }
+
+    settings.endArray();
+    settings.endGroup();
+}
+
 void SessionManager::saveSession(MainWindow *window)
 {
     qInfo(Q_FUNC_INFO);
 
-    clear();
-
     // Early out if no flags are set
     if (fileTypes == SessionManager::None) {
+        clear();
         return;
     }
 
+    usedSessionFileNames.clear();
+
     const ScintillaNext *currentEditor = window->currentEditor();
     int currentEditorIndex = 0;
-    QSettings settings;
-
-    settings.beginGroup("CurrentSession");
+    QVector<SessionEntry> entries;
 
-    settings.beginWriteArray("OpenedFiles");
-
-    int index = 0;
     for (const auto &editor : window->editors()) {
-        settings.setArrayIndex(index);
-
+        SessionEntry entry;
         SessionFileType editorType = determineType(editor);
 
+        if (!fileTypes.testFlag(editorType)) {
+            continue;
+        }
+
         if (editorType == SessionManager::SavedFile) {
-            if (fileTypes.testFlag(SessionManager::SavedFile)) {
-                storeFileDetails(editor, settings);
-            }
-            else {
-                continue;
-            }
+            storeFileDetails(editor, entry);
         }
         else if (editorType == SessionManager::UnsavedFile) {
-            if (fileTypes.testFlag(SessionManager::UnsavedFile)) {
-                storeUnsavedFileDetails(editor, settings);
-            }
-            else {
-                continue;
-            }
+            storeUnsavedFileDetails(editor, entry);
         }
         else if (editorType == SessionManager::TempFile) {
-            if (fileTypes.testFlag(SessionManager::TempFile)) {
-                storeTempFile(editor, settings);
-            }
-            else {
-                continue;
-            }
+            storeTempFile(editor, entry);
         }
         else {
             continue;
         }
 
         if (currentEditor == editor) {
-            currentEditorIndex = index;
+            currentEditorIndex = entries.size();
         }
 
-        ++index;
+        entries.append(entry);
     }
 
-    settings.endArray();
+    waitForPendingSaves();
 
-    settings.setValue("CurrentEditorIndex", currentEditorIndex);
+    // If anything goes wrong part way through the previous session is still there
+    if (!writeSessionStore(entries, currentEditorIndex)) {
+        return;
+    }
 
-    settings.endGroup();
+    // The session isn't kept in the settings anymore
+    clearSettings();
+
+    removeStaleSessionFiles(usedSessionFileNames);
 }
 
 void SessionManager::loadSession(MainWindow *window, EditorManager *editorManager)
 {
     qInfo(Q_FUNC_INFO);
 
-    QSettings settings;
-
-    settings.beginGroup("CurrentSession");
-
     ScintillaNext *currentEditor = Q_NULLPTR;
-    const int currentEditorIndex = settings.value("CurrentEditorIndex").toInt();
-    const int size = settings.beginReadArray("OpenedFiles");
+    int currentEditorIndex = 0;
+    QVector<SessionEntry> entries;
+
+    if (!readSessionStore(entries, currentEditorIndex)) {
+        readLegacySession(entries, currentEditorIndex);
+    }
 
     // NOTE: In theory the fileTypes should determine what is loaded, however if the session fileTypes
-    // change from the last time it was saved then it means the settings were manually altered outside of the app,
+    // change from the last time it was saved then it means the session was manually altered outside of the app,
     // which is non-standard behavior, so just load anything in the file
 
-    for (int index = 0; index < size; ++index) {
-        settings.setArrayIndex(index);
+    // Buffers recovered after a crash replace the session files they came from
+    QHash<QString, ScintillaNext *> openSessionFileNames;
+    for (ScintillaNext *editor : window->editors()) {
+        if (!sessionFileName(editor).isEmpty()) {
+            openSessionFileNames.insert(sessionFileName(editor), editor);
+        }
+    }
 
+    for (int index = 0; index < entries.size(); ++index) {
+        const SessionEntry &entry = entries.at(index);
         ScintillaNext *editor = Q_NULLPTR;
 
-        if (settings.contains("Type")) {
-            const QString type = settings.value("Type").toString();
-
-            if (type == QStringLiteral("File")) {
-                editor = loadFileDetails(settings, editorManager);
-            }
-            else if (type == QStringLiteral("UnsavedFile")) {
-                editor = loadUnsavedFileDetails(settings, editorManager);
-            }
-            else if (type == QStringLiteral("Temp")) {
-                editor = loadTempFile(settings, editorManager);
-            }
-            else {
-                qDebug("Unknown session entry type: %s", qUtf8Printable(type));
-            }
-
-            if (editor) {
-                 if (currentEditorIndex == index) {
-                    currentEditor = editor;
-                }
-            }
+        if (!entry.sessionFileName.isEmpty() && openSessionFileNames.contains(entry.sessionFileName)) {
+            qDebug("Session file \"%s\" is already open, skipping", qUtf8Printable(entry.sessionFileName));
+            editor = openSessionFileNames.value(entry.sessionFileName);
+        }
+        else if (entry.type == SessionManager::SavedFile) {
+            editor = loadFileDetails(entry, editorManager);
+        }
+        else if (entry.type == SessionManager::UnsavedFile) {
+            editor = loadUnsavedFileDetails(entry, editorManager);
+        }
+        else if (entry.type == SessionManager::TempFile) {
+            editor = loadTempFile(entry, editorManager);
         }
         else {
             qDebug("Unknown session entry type for index %d", index);
         }
-    }
-
-    settings.endArray();
 
-    settings.endGroup();
+        if (editor) {
+            if (currentEditorIndex == index) {
+                currentEditor = editor;
+            }
+        }
+    }
 
     if (currentEditor) {
         window->switchToEditor(currentEditor);
@@ -233,19 +476,19 @@ bool SessionManager::willFileGetStoredInSession(ScintillaNext *editor) const
     return fileTypes.testFlag(editorType);
 }
 
-void SessionManager::storeFileDetails(ScintillaNext *editor, QSettings &settings)
+void SessionManager::storeFileDetails(ScintillaNext *editor, SessionEntry &entry)
 {
-    settings.setValue("Type", "File");
-    settings.setValue("FilePath", editor->getFilePath());
+    entry.type = SessionManager::SavedFile;
+    entry.filePath = editor->getFilePath();
 
-    storeEditorViewDetails(editor, settings);
+    storeEditorViewDetails(editor, entry);
 }
 
-ScintillaNext* SessionManager::loadFileDetails(QSettings &settings, EditorManager *editorManager)
+ScintillaNext* SessionManager::loadFileDetails(const SessionEntry &entry, EditorManager *editorManager)
 {
     qInfo(Q_FUNC_INFO);
 
-    const QString filePath = settings.value("FilePath").toString();
+    const QString &filePath = entry.filePath;
 
     qDebug("Session file: \"%s\"", qUtf8Printable(filePath));
 
@@ -256,12 +499,17 @@ ScintillaNext* SessionManager::loadFileDetails(QSettings &settings, EditorManage
     }
 
     if (QFileInfo::exists(filePath)) {
-        editor = ScintillaNext::fromFile(filePath);
+        // The file isn't read until the tab is shown, otherwise a big session takes forever to open
+        editor = editorManager->openFileDeferred(filePath);
 
-        loadEditorViewDetails(editor, settings);
+        if (editor == Q_NULLPTR) {
+            return Q_NULLPTR;
+        }
 
         editorManager->manageEditor(editor);
 
+        loadEditorViewDetails(editor, entry);
+
         return editor;
     }
     else {
@@ -270,25 +518,26 @@ ScintillaNext* SessionManager::loadFileDetails(QSettings &settings, EditorManage
     }
 }
 
-void SessionManager::storeUnsavedFileDetails(ScintillaNext *editor, QSettings &settings)
+void SessionManager::storeUnsavedFileDetails(ScintillaNext *editor, SessionEntry &entry)
 {
-    const QString sessionFileName = RandomSessionFileName();
+    const QString sessionFileName = sessionFileNameFor(editor);
 
-    settings.setValue("Type", "UnsavedFile");
-    settings.setValue("FilePath", editor->getFilePath());
-    settings.setValue("SessionFileName", sessionFileName);
+    entry.type = SessionManager::UnsavedFile;
+    entry.filePath = editor->getFilePath();
+    entry.sessionFileName = sessionFileName;
 
-    storeEditorViewDetails(editor, settings);
+    storeEditorViewDetails(editor, entry);
+    storeEditorEncoding(editor, entry);
 
     saveIntoSessionDirectory(editor, sessionFileName);
 }
 
-ScintillaNext *SessionManager::loadUnsavedFileDetails(QSettings &settings, EditorManager *editorManager)
+ScintillaNext *SessionManager::loadUnsavedFileDetails(const SessionEntry &entry, EditorManager *editorManager)
 {
     qInfo(Q_FUNC_INFO);
 
-    const QString filePath = settings.value("FilePath").toString();
-    const QString sessionFileName = settings.value("SessionFileName").toString();
+    const QString &filePath = entry.filePath;
+    const QString &sessionFileName = entry.sessionFileName;
     const QString sessionFilePath = sessionDirectory().filePath(sessionFileName);
 
     qDebug("Session file: \"%s\"", qUtf8Printable(filePath));
@@ -301,16 +550,20 @@ ScintillaNext *SessionManager::loadUnsavedFileDetails(QSettings &settings, Edito
     }
 
     if (QFileInfo::exists(filePath) && QFileInfo::exists(sessionFilePath)) {
-        ScintillaNext *editor = ScintillaNext::fromFile(sessionFilePath);
+        ScintillaNext *editor = new ScintillaNext(QFileInfo(filePath).fileName());
 
         // Since this editor has different file path info, treat this as a temporary buffer
         editor->setFileInfo(filePath);
         editor->setTemporary(true);
+        editor->deferLoad(sessionFilePath, editorManager->documentOptionsForFile(sessionFilePath));
 
-        loadEditorViewDetails(editor, settings);
+        loadSessionFileName(editor, sessionFileName);
 
         editorManager->manageEditor(editor);
 
+        loadEditorViewDetails(editor, entry);
+        loadEditorEncoding(editor, entry);
+
         return editor;
     }
     else {
@@ -320,39 +573,43 @@ ScintillaNext *SessionManager::loadUnsavedFileDetails(QSettings &settings, Edito
     }
 }
 
-void SessionManager::storeTempFile(ScintillaNext *editor, QSettings &settings)
+void SessionManager::storeTempFile(ScintillaNext *editor, SessionEntry &entry)
 {
-    const QString sessionFileName = RandomSessionFileName();
+    const QString sessionFileName = sessionFileNameFor(editor);
 
-    settings.setValue("Type", "Temp");
-    settings.setValue("FileName", editor->getName());
-    settings.setValue("SessionFileName", sessionFileName);
+    entry.type = SessionManager::TempFile;
+    entry.fileName = editor->getName();
+    entry.sessionFileName = sessionFileName;
 
-    storeEditorViewDetails(editor, settings);
+    storeEditorViewDetails(editor, entry);
+    storeEditorEncoding(editor, entry);
 
     saveIntoSessionDirectory(editor, sessionFileName);
 }
 
-ScintillaNext *SessionManager::loadTempFile(QSettings &settings, EditorManager *editorManager)
+ScintillaNext *SessionManager::loadTempFile(const SessionEntry &entry, EditorManager *editorManager)
 {
     qInfo(Q_FUNC_INFO);
 
-    const QString fileName = settings.value("FileName").toString();
-    const QString sessionFileName = settings.value("SessionFileName").toString();
+    const QString &fileName = entry.fileName;
+    const QString &sessionFileName = entry.sessionFileName;
     const QString fullFilePath = sessionDirectory().filePath(sessionFileName);
 
     qDebug("Session temp file: \"%s\"", qUtf8Printable(fullFilePath));
 
     if (QFileInfo::exists(fullFilePath)) {
-        ScintillaNext *editor = ScintillaNext::fromFile(fullFilePath, false);
+        ScintillaNext *editor = new ScintillaNext(fileName);
 
-        editor->detachFileInfo(fileName);
         editor->setTemporary(true);
+        editor->deferLoad(fullFilePath, editorManager->documentOptionsForFile(fullFilePath));
 
-        loadEditorViewDetails(editor, settings);
+        loadSessionFileName(editor, sessionFileName);
 
         editorManager->manageEditor(editor);
 
+        loadEditorViewDetails(editor, entry);
+        loadEditorEncoding(editor, entry);
+
         return editor;
     }
     else {
@@ -361,17 +618,161 @@ ScintillaNext *SessionManager::loadTempFile(QSettings &settings, EditorManager *
     }
 }
 
-void SessionManager::storeEditorViewDetails(ScintillaNext *editor, QSettings &settings)
+void SessionManager::loadSessionFileName(ScintillaNext *editor, const QString &sessionFileName)
+{
+    setSessionFileName(editor, sessionFileName);
+
+    // The buffer matches the session file as soon as it has been read
+    whenLoaded(editor, [=]() {
+        editor->QObject::setProperty(SESSION_MODIFICATION_COUNT, static_cast<qulonglong>(editor->getModificationCount()));
+    });
+}
+
+void SessionManager::storeEditorEncoding(ScintillaNext *editor, SessionEntry &entry)
+{
+    // A placeholder only gets its real encoding once it is loaded, so pass along what it was restored with
+    if (editor->isLoadDeferred() && editor->QObject::property(SESSION_ENCODING).isValid()) {
+        entry.encoding = editor->QObject::property(SESSION_ENCODING).toByteArray();
+        entry.encodingHasBom = editor->QObject::property(SESSION_ENCODING_HAS_BOM).toBool();
+        return;
+    }
+
+    const FileEncoding encoding = editor->getEncoding();
+
+    entry.encoding = encoding.codecName;
+    entry.encodingHasBom = encoding.hasBom;
+}
+
+void SessionManager::loadEditorEncoding(ScintillaNext *editor, const SessionEntry &entry)
 {
-    settings.setValue("FirstVisibleLine", static_cast<int>(editor->firstVisibleLine() + 1)); // Keep it 1-based in the settings just for human-readability
-    settings.setValue("CurrentPosition", static_cast<int>(editor->currentPos()));
+    FileEncoding encoding;
+    encoding.codecName = entry.encoding;
+    encoding.hasBom = entry.encodingHasBom;
+
+    editor->QObject::setProperty(SESSION_ENCODING, encoding.codecName);
+    editor->QObject::setProperty(SESSION_ENCODING_HAS_BOM, encoding.hasBom);
+
+    // The session copy was UTF-8 so the detected encoding needs to be replaced once it is loaded
+    whenLoaded(editor, [=]() {
+        editor->setEncoding(encoding);
+    });
 }
 
-void SessionManager::loadEditorViewDetails(ScintillaNext *editor, QSettings &settings)
+void SessionManager::storeEditorViewDetails(ScintillaNext *editor, SessionEntry &entry)
 {
-    const int firstVisibleLine = settings.value("FirstVisibleLine").toInt() - 1;
-    const int currentPosition = settings.value("CurrentPosition").toInt();
+    // Placeholder tabs never had their view set up, so pass along what they were restored with
+    if (editor->isLoading() && editor->QObject::property(SESSION_VIEW_STATE).isValid()) {
+        entry.viewState = editor->QObject::property(SESSION_VIEW_STATE).toByteArray();
+        return;
+    }
+
+    QDataStream stream(&entry.viewState, QIODevice::WriteOnly);
+
+    stream << static_cast<qint64>(editor->firstVisibleLine());
+
+    stream << static_cast<qint32>(editor->selections()) << static_cast<qint32>(editor->mainSelection());
+    for (int i = 0; i < editor->selections(); ++i) {
+        stream << static_cast<qint64>(editor->selectionNAnchor(i)) << static_cast<qint64>(editor->selectionNCaret(i));
+    }
+
+    QVector<qint64> foldedLines;
+    for (Sci_Position line = editor->contractedFoldNext(0); line != -1; line = editor->contractedFoldNext(line + 1)) {
+        foldedLines.append(line);
+    }
+
+    QVector<qint64> bookmarkedLines;
+    BookMarkDecorator *bookMarkDecorator = editor->findChild<BookMarkDecorator*>(QString(), Qt::FindDirectChildrenOnly);
+    if (bookMarkDecorator) {
+        for (Sci_Position line : bookMarkDecorator->bookmarkedLines()) {
+            bookmarkedLines.append(line);
+        }
+    }
+
+    stream << foldedLines << bookmarkedLines;
+}
+
+void SessionManager::loadEditorViewDetails(ScintillaNext *editor, const SessionEntry &entry)
+{
+    const QByteArray viewState = entry.viewState;
+
+    editor->QObject::setProperty(SESSION_VIEW_STATE, viewState);
+
+    // The positions are meaningless until the text is actually there. This has to happen after the editor
+    // is managed so the lexer is already set up by the time the folds are restored.
+    whenLoaded(editor, [=]() {
+        editor->QObject::setProperty(SESSION_VIEW_STATE, QVariant());
+
+        QDataStream stream(viewState);
+
+        qint64 firstVisibleLine;
+        qint32 selections;
+        qint32 mainSelection;
 
-    editor->setFirstVisibleLine(firstVisibleLine);
-    editor->setEmptySelection(currentPosition);
+        stream >> firstVisibleLine >> selections >> mainSelection;
+
+        QVector<QPair<qint64, qint64>> ranges;
+        for (int i = 0; i < selections && stream.status() == QDataStream::Ok; ++i) {
+            qint64 anchor;
+            qint64 caret;
+
+            stream >> anchor >> caret;
+            ranges.append(qMakePair(anchor, caret));
+        }
+
+        QVector<qint64> foldedLines;
+        QVector<qint64> bookmarkedLines;
+
+        stream >> foldedLines >> bookmarkedLines;
+
+        if (stream.status() != QDataStream::Ok) {
+            qWarning("Invalid view state for \"%s\"", qUtf8Printable(editor->getName()));
+            return;
+        }
+
+        if (!foldedLines.isEmpty()) {
+            // Fold levels only exist once the lines have been styled
+            editor->colourise(0, editor->lineEndPosition(foldedLines.last()));
+
+            for (qint64 line : qAsConst(foldedLines)) {
+                editor->foldLine(line, SC_FOLDACTION_CONTRACT);
+            }
+        }
+
+        BookMarkDecorator *bookMarkDecorator = editor->findChild<BookMarkDecorator*>(QString(), Qt::FindDirectChildrenOnly);
+        if (bookMarkDecorator) {
+            for (qint64 line : qAsConst(bookmarkedLines)) {
+                bookMarkDecorator->toggleBookmark(line);
+            }
+        }
+
+        for (int i = 0; i < ranges.size(); ++i) {
+            if (i == 0) {
+                editor->setSelection(ranges[i].second, ranges[i].first);
+            }
+            else {
+                editor->addSelection(ranges[i].second, ranges[i].first);
+            }
+        }
+
+        if (mainSelection >= 0 && mainSelection < ranges.size()) {
+            editor->setMainSelection(mainSelection);
+        }
+
+        // Folding changes which lines are visible, so this goes last
+        editor->setFirstVisibleLine(firstVisibleLine);
+    });
+}
+
+void SessionManager::whenLoaded(ScintillaNext *editor, const std::function<void ()> &callback)
+{
+    if (editor->isLoading()) {
+        QObject::connect(editor, &ScintillaNext::loadFinished, editor, [=](bool success) {
+            if (success) {
+                callback();
+            }
+        });
+    }
+    else {
+        callback();
+    }
 }
@@ -22,9 +22,14 @@
 
 
 #include <QDir>
-#include <QSettings>
+#include <QList>
+#include <QPointer>
+#include <QVector>
 
+#include <functional>
 
+
+class FileSaver;
 class ScintillaNext;
 class EditorManager;
 class MainWindow;
@@ -40,6 +45,20 @@ public:
     };
     Q_DECLARE_FLAGS(SessionFileTypes, SessionFileType)
 
+    // Everything needed to bring back a single tab
+    struct SessionEntry {
+        SessionFileType type = None;
+        QString filePath;
+        QString fileName;
+        QString sessionFileName;
+        QByteArray encoding;
+        bool encodingHasBom = false;
+
+        // First visible line, selections, folds and bookmarks. Kept as an opaque blob so a tab that was
+        // never loaded can hand it straight back when the session is saved again.
+        QByteArray viewState;
+    };
+
 
     SessionManager(SessionFileTypes types = SessionFileTypes());
 
@@ -52,29 +71,57 @@ public:
 
     bool willFileGetStoredInSession(ScintillaNext *editor) const;
 
+    // The file in the session directory that holds the buffer, empty if it hasn't been stored yet
+    static QString sessionFileName(const ScintillaNext *editor);
+    static void setSessionFileName(ScintillaNext *editor, const QString &sessionFileName);
+
 private:
     QDir sessionDirectory() const;
+    QString sessionStoreFilePath() const;
+
+    QString sessionFileNameFor(ScintillaNext *editor) const;
+    void saveIntoSessionDirectory(ScintillaNext *editor, const QString &sessionFileName);
+    void waitForPendingSaves();
+    void removeStaleSessionFiles(const QStringList &sessionFileNames) const;
+
+    // The session is stored in a single binary file that is read in one go
+    bool writeSessionStore(const QVector<SessionEntry> &entries, int currentEditorIndex) const;
+    bool readSessionStore(QVector<SessionEntry> &entries, int &currentEditorIndex) const;
 
-    void saveIntoSessionDirectory(ScintillaNext *editor, const QString &sessionFileName) const;
+    // Older versions kept the session in the settings
+    void readLegacySession(QVector<SessionEntry> &entries, int &currentEditorIndex) const;
 
     SessionFileType determineType(ScintillaNext *editor) const;
 
     void clearSettings() const;
     void clearDirectory() const;
 
-    void storeFileDetails(ScintillaNext *editor, QSettings &settings);
-    ScintillaNext *loadFileDetails(QSettings &settings, EditorManager *editorManager);
+    void storeFileDetails(ScintillaNext *editor, SessionEntry &entry);
+    ScintillaNext *loadFileDetails(const SessionEntry &entry, EditorManager *editorManager);
 
-    void storeUnsavedFileDetails(ScintillaNext *editor, QSettings &settings);
-    ScintillaNext *loadUnsavedFileDetails(QSettings &settings, EditorManager *editorManager);
+    void storeUnsavedFileDetails(ScintillaNext *editor, SessionEntry &entry);
+    ScintillaNext *loadUnsavedFileDetails(const SessionEntry &entry, EditorManager *editorManager);
 
-    void storeTempFile(ScintillaNext *editor, QSettings &settings);
-    ScintillaNext *loadTempFile(QSettings &settings, EditorManager *editorManager);
+    void storeTempFile(ScintillaNext *editor, SessionEntry &entry);
+    ScintillaNext *loadTempFile(const SessionEntry &entry, EditorManager *editorManager);
 
-    void storeEditorViewDetails(ScintillaNext *editor, QSettings &settings);
-    void loadEditorViewDetails(ScintillaNext *editor, QSettings &settings);
+    void storeEditorViewDetails(ScintillaNext *editor, SessionEntry &entry);
+    void loadEditorViewDetails(ScintillaNext *editor, const SessionEntry &entry);
+
+    void loadSessionFileName(ScintillaNext *editor, const QString &sessionFileName);
+
+    void storeEditorEncoding(ScintillaNext *editor, SessionEntry &entry);
+    void loadEditorEncoding(ScintillaNext *editor, const SessionEntry &entry);
+
+    static void whenLoaded(ScintillaNext *editor, const std::function<void ()> &callback);
 
     SessionFileTypes fileTypes;
+
+    // Buffers are written to the session directory in parallel while the session is being stored
+    QList<QPointer<FileSaver>> pendingSaves;
+
+    // Session files that are referenced by the session currently being saved
+    QStringList usedSessionFileNames;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(SessionManager::SessionFileTypes)
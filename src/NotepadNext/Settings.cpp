@@ -34,9 +34,14 @@ bool Settings::tabsClosable() const { return m_tabsClosable; }
 bool Settings::restorePreviousSession() const { return m_restorePreviousSession; }
 bool Settings::restoreUnsavedFiles() const { return m_restoreUnsavedFiles; }
 bool Settings::restoreTempFiles() const { return m_restoreTempFiles; }
+bool Settings::prefetchSessionFiles() const { return m_prefetchSessionFiles; }
 
 bool Settings::combineSearchResults() const { return m_combineSearchResults; }
 
+int Settings::largeFileSize() const { return m_largeFileSize; }
+int Settings::largeFileLineLength() const { return m_largeFileLineLength; }
+int Settings::pagedFileSize() const { return m_pagedFileSize; }
+
 void Settings::setShowMenuBar(bool showMenuBar)
 {
     if (m_showMenuBar == showMenuBar)
@@ -109,6 +114,15 @@ void Settings::setRestoreTempFiles(bool restoreTempFiles)
     emit restoreTempFilesChanged(m_restoreTempFiles);
 }
 
+void Settings::setPrefetchSessionFiles(bool prefetchSessionFiles)
+{
+    if (m_prefetchSessionFiles == prefetchSessionFiles)
+        return;
+
+    m_prefetchSessionFiles = prefetchSessionFiles;
+    emit prefetchSessionFilesChanged(m_prefetchSessionFiles);
+}
+
 void Settings::setCombineSearchResults(bool combineSearchResults)
 {
     if (m_combineSearchResults == combineSearchResults)
@@ -117,3 +131,30 @@ void Settings::setCombineSearchResults(bool combineSearchResults)
     m_combineSearchResults = combineSearchResults;
     emit combineSearchResultsChanged(m_combineSearchResults);
 }
+
+void Settings::setLargeFileSize(int largeFileSize)
+{
+    if (m_largeFileSize == largeFileSize)
+        return;
+
+    m_largeFileSize = largeFileSize;
+    emit largeFileSizeChanged(m_largeFileSize);
+}
+
+void Settings::setLargeFileLineLength(int largeFileLineLength)
+{
+    if (m_largeFileLineLength == largeFileLineLength)
+        return;
+
+    m_largeFileLineLength = largeFileLineLength;
+    emit largeFileLineLengthChanged(m_largeFileLineLength);
+}
+
+void Settings::setPagedFileSize(int pagedFileSize)
+{
+    if (m_pagedFileSize == pagedFileSize)
+        return;
+
+    m_pagedFileSize = pagedFileSize;
+    emit pagedFileSizeChanged(m_pagedFileSize);
+}
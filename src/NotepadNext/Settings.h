@@ -37,9 +37,14 @@ class Settings : public QObject
     Q_PROPERTY(bool restorePreviousSession READ restorePreviousSession WRITE setRestorePreviousSession NOTIFY restorePreviousSessionChanged)
     Q_PROPERTY(bool restoreUnsavedFiles READ restoreUnsavedFiles WRITE setRestoreUnsavedFiles NOTIFY restoreUnsavedFilesChanged)
     Q_PROPERTY(bool restoreTempFiles READ restoreTempFiles WRITE setRestoreTempFiles NOTIFY restoreTempFilesChanged)
+    Q_PROPERTY(bool prefetchSessionFiles READ prefetchSessionFiles WRITE setPrefetchSessionFiles NOTIFY prefetchSessionFilesChanged)
 
     Q_PROPERTY(bool combineSearchResults READ combineSearchResults WRITE setCombineSearchResults NOTIFY combineSearchResultsChanged)
 
+    Q_PROPERTY(int largeFileSize READ largeFileSize WRITE setLargeFileSize NOTIFY largeFileSizeChanged)
+    Q_PROPERTY(int largeFileLineLength READ largeFileLineLength WRITE setLargeFileLineLength NOTIFY largeFileLineLengthChanged)
+    Q_PROPERTY(int pagedFileSize READ pagedFileSize WRITE setPagedFileSize NOTIFY pagedFileSizeChanged)
+
     bool m_showMenuBar = true;
     bool m_showToolBar = true;
     bool m_showTabBar = true;
@@ -50,9 +55,14 @@ class Settings : public QObject
     bool m_restorePreviousSession = false;
     bool m_restoreUnsavedFiles = false;
     bool m_restoreTempFiles = false;
+    bool m_prefetchSessionFiles = false;
 
     bool m_combineSearchResults = false;
 
+    int m_largeFileSize = 200; // In megabytes
+    int m_largeFileLineLength = 100000;
+    int m_pagedFileSize = 2048; // In megabytes
+
 public:
     explicit Settings(QObject *parent = nullptr);
 
@@ -66,9 +76,14 @@ public:
     bool restorePreviousSession() const;
     bool restoreUnsavedFiles() const;
     bool restoreTempFiles() const;
+    bool prefetchSessionFiles() const;
 
     bool combineSearchResults() const;
 
+    int largeFileSize() const;
+    int largeFileLineLength() const;
+    int pagedFileSize() const;
+
 signals:
     void showMenuBarChanged(bool showMenuBar);
     void showToolBarChanged(bool showToolBar);
@@ -80,9 +95,14 @@ signals:
     void restorePreviousSessionChanged(bool restorePreviousSession);
     void restoreUnsavedFilesChanged(bool restureUnsavedFiles);
     void restoreTempFilesChanged(bool restoreTempFiles);
+    void prefetchSessionFilesChanged(bool prefetchSessionFiles);
 
     void combineSearchResultsChanged(bool combineSearchResults);
 
+    void largeFileSizeChanged(int largeFileSize);
+    void largeFileLineLengthChanged(int largeFileLineLength);
+    void pagedFileSizeChanged(int pagedFileSize);
+
 public slots:
     void setShowMenuBar(bool showMenuBar);
     void setShowToolBar(bool showToolBar);
@@ -94,8 +114,13 @@ public slots:
     void setRestorePreviousSession(bool restorePreviousSession);
     void setRestoreUnsavedFiles(bool restoreUnsavedFiles);
     void setRestoreTempFiles(bool restoreTempFiles);
+    void setPrefetchSessionFiles(bool prefetchSessionFiles);
 
     void setCombineSearchResults(bool combineSearchResults);
+
+    void setLargeFileSize(int largeFileSize);
+    void setLargeFileLineLength(int largeFileLineLength);
+    void setPagedFileSize(int pagedFileSize);
 };
 
 #endif // SETTINGS_H
@@ -0,0 +1,54 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SIMDHELPERS_H
+#define SIMDHELPERS_H
+
+// SSE2 is part of the x86-64 baseline so it can always be used there. AVX2 is only compiled for
+// GCC/Clang using per-function target attributes and has to be checked for at runtime.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NN_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(NN_SIMD_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define NN_SIMD_AVX2
+#define NN_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+namespace SimdHelpers
+{
+    inline bool hasAvx2()
+    {
+#ifdef NN_SIMD_AVX2
+        static const bool supported = []() {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+        }();
+
+        return supported;
+#else
+        return false;
+#endif
+    }
+}
+
+#endif // SIMDHELPERS_H
@@ -0,0 +1,260 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "TextDiff.h"
+
+#include <cstring>
+#include <vector>
+
+
+namespace {
+
+const qint64 BLOCK_SIZE = 4096;
+
+struct Lines {
+    const char *data;
+    // Offset of each line, plus one extra for the end of the last line
+    QVector<qint64> starts;
+    QVector<quint64> hashes;
+};
+
+// A line ends with \n, \r\n, or a lone \r
+bool isLineStart(const char *data, qint64 length, qint64 position)
+{
+    if (position == 0 || position == length) {
+        return true;
+    }
+
+    const char previous = data[position - 1];
+    return previous == '\n' || (previous == '\r' && data[position] != '\n');
+}
+
+Lines splitLines(const char *data, qint64 length)
+{
+    // FNV-1a
+    const quint64 offsetBasis = Q_UINT64_C(14695981039346656037);
+    const quint64 prime = Q_UINT64_C(1099511628211);
+
+    Lines lines;
+    lines.data = data;
+
+    quint64 hash = offsetBasis;
+    qint64 start = 0;
+
+    for (qint64 i = 0; i < length; ++i) {
+        const char c = data[i];
+        hash = (hash ^ static_cast<uchar>(c)) * prime;
+
+        if (c == '\n' || (c == '\r' && (i + 1 == length || data[i + 1] != '\n'))) {
+            lines.starts.append(start);
+            lines.hashes.append(hash);
+
+            start = i + 1;
+            hash = offsetBasis;
+        }
+    }
+
+    if (start < length) {
+        lines.starts.append(start);
+        lines.hashes.append(hash);
+    }
+
+    lines.starts.append(length);
+
+    return lines;
+}
+
+// memcmp() is much faster than comparing a byte at a time, so only fall back to that once a block differs
+qint64 commonPrefix(const char *a, const char *b, qint64 length)
+{
+    qint64 prefix = 0;
+    while (prefix + BLOCK_SIZE <= length && memcmp(a + prefix, b + prefix, BLOCK_SIZE) == 0) {
+        prefix += BLOCK_SIZE;
+    }
+
+    while (prefix < length && a[prefix] == b[prefix]) {
+        ++prefix;
+    }
+
+    return prefix;
+}
+
+qint64 commonSuffix(const char *aEnd, const char *bEnd, qint64 length)
+{
+    qint64 suffix = 0;
+    while (suffix + BLOCK_SIZE <= length && memcmp(aEnd - suffix - BLOCK_SIZE, bEnd - suffix - BLOCK_SIZE, BLOCK_SIZE) == 0) {
+        suffix += BLOCK_SIZE;
+    }
+
+    while (suffix < length && aEnd[-suffix - 1] == bEnd[-suffix - 1]) {
+        ++suffix;
+    }
+
+    return suffix;
+}
+
+bool sameLine(const Lines &a, int i, const Lines &b, int j)
+{
+    if (a.hashes[i] != b.hashes[j]) {
+        return false;
+    }
+
+    const qint64 length = a.starts[i + 1] - a.starts[i];
+
+    // Don't trust the hash alone, a collision would corrupt the document
+    return length == b.starts[j + 1] - b.starts[j] && memcmp(a.data + a.starts[i], b.data + b.starts[j], length) == 0;
+}
+
+}
+
+namespace TextDiff {
+
+QVector<Hunk> diffLines(const char *oldData, qint64 oldLength, const char *newData, qint64 newLength, int maxEdits)
+{
+    QVector<Hunk> hunks;
+
+    // Most reloads only touch a small part of the file, so skip over everything that is the same at
+    // either end before doing any line by line work
+    const qint64 shortest = qMin(oldLength, newLength);
+
+    qint64 prefix = commonPrefix(oldData, newData, shortest);
+
+    if (prefix == oldLength && prefix == newLength) {
+        return hunks;
+    }
+
+    qint64 suffix = commonSuffix(oldData + oldLength, newData + newLength, shortest - prefix);
+
+    // Only whole lines are compared, so back up to line boundaries that both texts agree on
+    while (prefix > 0 && !(isLineStart(oldData, oldLength, prefix) && isLineStart(newData, newLength, prefix))) {
+        --prefix;
+    }
+
+    while (suffix > 0 && !(isLineStart(oldData, oldLength, oldLength - suffix) && isLineStart(newData, newLength, newLength - suffix))) {
+        --suffix;
+    }
+
+    const Lines oldLines = splitLines(oldData + prefix, oldLength - prefix - suffix);
+    const Lines newLines = splitLines(newData + prefix, newLength - prefix - suffix);
+
+    const int n = oldLines.hashes.size();
+    const int m = newLines.hashes.size();
+
+    auto addHunk = [&](int oldStart, int oldEnd, int newStart, int newEnd) {
+        hunks.append({prefix + oldLines.starts[oldStart], oldLines.starts[oldEnd] - oldLines.starts[oldStart],
+                      prefix + newLines.starts[newStart], newLines.starts[newEnd] - newLines.starts[newStart]});
+    };
+
+    // Myers' O(ND) algorithm. The furthest reaching path for each diagonal is kept for every step so
+    // the edits can be recovered by walking back through them.
+    const int limit = qMin(n + m, maxEdits);
+    std::vector<int> v(2 * limit + 3, 0);
+    std::vector<std::vector<int>> trace;
+    const int offset = limit + 1;
+    int edits = -1;
+
+    for (int d = 0; d <= limit && edits == -1; ++d) {
+        for (int k = -d; k <= d; k += 2) {
+            int x;
+            if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])) {
+                x = v[offset + k + 1];
+            }
+            else {
+                x = v[offset + k - 1] + 1;
+            }
+
+            int y = x - k;
+            while (x < n && y < m && sameLine(oldLines, x, newLines, y)) {
+                ++x;
+                ++y;
+            }
+
+            v[offset + k] = x;
+
+            if (x >= n && y >= m) {
+                edits = d;
+            }
+        }
+
+        trace.emplace_back(v.begin() + offset - d, v.begin() + offset + d + 1);
+    }
+
+    // Too many changes, just replace everything in between
+    if (edits == -1) {
+        addHunk(0, n, 0, m);
+        return hunks;
+    }
+
+    // Walk back from the end collecting the single line insertions and deletions
+    struct Edit {
+        int x;
+        int y;
+        bool isInsert;
+    };
+
+    QVector<Edit> script;
+    int x = n;
+    int y = m;
+
+    for (int d = edits; d > 0; --d) {
+        const std::vector<int> &previous = trace[d - 1];
+        const int k = x - y;
+
+        const bool isInsert = k == -d || (k != d && previous[k - 1 + d - 1] < previous[k + 1 + d - 1]);
+        const int previousK = isInsert ? k + 1 : k - 1;
+        const int previousX = previous[previousK + d - 1];
+        const int previousY = previousX - previousK;
+
+        script.append({previousX, previousY, isInsert});
+
+        x = previousX;
+        y = previousY;
+    }
+
+    // Join neighboring edits together into hunks
+    int oldStart = 0, oldEnd = -1, newStart = 0, newEnd = -1;
+
+    for (int i = script.size() - 1; i >= 0; --i) {
+        const Edit &edit = script[i];
+
+        if (edit.x != oldEnd || edit.y != newEnd) {
+            if (oldEnd != -1) {
+                addHunk(oldStart, oldEnd, newStart, newEnd);
+            }
+
+            oldStart = oldEnd = edit.x;
+            newStart = newEnd = edit.y;
+        }
+
+        if (edit.isInsert) {
+            ++newEnd;
+        }
+        else {
+            ++oldEnd;
+        }
+    }
+
+    if (oldEnd != -1) {
+        addHunk(oldStart, oldEnd, newStart, newEnd);
+    }
+
+    return hunks;
+}
+
+}
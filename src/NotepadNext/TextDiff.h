@@ -0,0 +1,43 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TEXTDIFF_H
+#define TEXTDIFF_H
+
+#include <QVector>
+
+
+namespace TextDiff {
+
+// A range of bytes in the old text that gets replaced by a range of bytes from the new text
+struct Hunk {
+    qint64 oldStart;
+    qint64 oldLength;
+    qint64 newStart;
+    qint64 newLength;
+};
+
+// Compares the two texts line by line and returns the hunks, in order, that turn the old text into
+// the new one. If the texts are too different to be worth diffing the changed region is returned as
+// a single hunk.
+QVector<Hunk> diffLines(const char *oldData, qint64 oldLength, const char *newData, qint64 newLength, int maxEdits = 2000);
+
+}
+
+#endif // TEXTDIFF_H
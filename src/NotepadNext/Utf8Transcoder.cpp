@@ -0,0 +1,267 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "Utf8Transcoder.h"
+#include "SimdHelpers.h"
+
+#include <QTextCodec>
+
+#include <cstring>
+
+
+namespace {
+
+const int MIB_UTF16BE = 1013;
+const int MIB_UTF16LE = 1014;
+
+bool isSingleByteMib(int mib)
+{
+    return mib == 4                       // ISO-8859-1
+        || (mib >= 5 && mib <= 13)        // ISO-8859-2 to ISO-8859-10
+        || (mib >= 109 && mib <= 112)     // ISO-8859-13 to ISO-8859-16
+        || (mib >= 2250 && mib <= 2258)   // Windows-1250 to Windows-1258
+        || mib == 2084                    // KOI8-R
+        || mib == 2086                    // IBM866
+        || mib == 2088;                   // KOI8-U
+}
+
+inline char *appendReplacement(char *out)
+{
+    *out++ = '\xEF';
+    *out++ = '\xBF';
+    *out++ = '\xBD';
+    return out;
+}
+
+inline char *appendCodePoint(uint codePoint, char *out)
+{
+    if (codePoint < 0x80) {
+        *out++ = static_cast<char>(codePoint);
+    }
+    else if (codePoint < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (codePoint >> 6));
+        *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    else if (codePoint < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (codePoint >> 12));
+        *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    else {
+        *out++ = static_cast<char>(0xF0 | (codePoint >> 18));
+        *out++ = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+
+    return out;
+}
+
+}
+
+Utf8Transcoder::Utf8Transcoder(const QTextCodec *codec)
+{
+    if (codec == Q_NULLPTR) {
+        return;
+    }
+
+    const int mib = codec->mibEnum();
+
+    if (mib == MIB_UTF16LE) {
+        kind = Utf16LE;
+    }
+    else if (mib == MIB_UTF16BE) {
+        kind = Utf16BE;
+    }
+    else if (isSingleByteMib(mib)) {
+        buildSingleByteTable(codec);
+    }
+}
+
+void Utf8Transcoder::transcode(const char *data, qint64 length, QByteArray &output)
+{
+    Q_ASSERT(isValid());
+
+    // Worst case is 3 bytes of UTF-8 for every input byte, plus anything left over from last time
+    output.resize(length * 3 + 8);
+
+    char *start = output.data();
+    char *out = start;
+
+    if (kind == SingleByte) {
+        out = transcodeSingleByte(reinterpret_cast<const unsigned char *>(data), length, out);
+    }
+    else {
+        out = transcodeUtf16(reinterpret_cast<const unsigned char *>(data), length, out);
+    }
+
+    output.resize(out - start);
+}
+
+void Utf8Transcoder::finish(QByteArray &output)
+{
+    output.clear();
+
+    if (pendingByte != -1 || pendingHighSurrogate != 0) {
+        char buffer[3];
+        output.append(buffer, appendReplacement(buffer) - buffer);
+    }
+
+    pendingByte = -1;
+    pendingHighSurrogate = 0;
+}
+
+void Utf8Transcoder::buildSingleByteTable(const QTextCodec *codec)
+{
+    for (int i = 0; i < 256; ++i) {
+        const char byte = static_cast<char>(i);
+        const QString decoded = codec->toUnicode(&byte, 1);
+
+        // Each byte needs to be exactly one character for this to work, and ASCII needs to be ASCII
+        if (decoded.size() != 1 || decoded.at(0).isSurrogate() || (i < 0x80 && decoded.at(0).unicode() != i)) {
+            qWarning("Codec '%s' is not a simple single byte encoding", codec->name().constData());
+            return;
+        }
+
+        tableLength[i] = static_cast<quint8>(appendCodePoint(decoded.at(0).unicode(), table[i]) - table[i]);
+    }
+
+    kind = SingleByte;
+}
+
+char *Utf8Transcoder::transcodeSingleByte(const unsigned char *data, qint64 length, char *out)
+{
+    qint64 i = 0;
+
+#ifdef NN_SIMD_SSE2
+    // Copy blocks of ASCII straight through
+    while (i + 16 <= length) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+
+        if (_mm_movemask_epi8(block) == 0) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), block);
+            out += 16;
+            i += 16;
+        }
+        else {
+            for (const qint64 end = i + 16; i < end; ++i) {
+                memcpy(out, table[data[i]], 3);
+                out += tableLength[data[i]];
+            }
+        }
+    }
+#endif
+
+    for (; i < length; ++i) {
+        memcpy(out, table[data[i]], 3);
+        out += tableLength[data[i]];
+    }
+
+    return out;
+}
+
+char *Utf8Transcoder::transcodeUtf16(const unsigned char *data, qint64 length, char *out)
+{
+    qint64 i = 0;
+
+    // Finish off a code unit that was split across chunks
+    if (pendingByte != -1 && length > 0) {
+        const unsigned char first = static_cast<unsigned char>(pendingByte);
+        const char16_t unit = kind == Utf16LE ? (first | (data[0] << 8)) : ((first << 8) | data[0]);
+
+        pendingByte = -1;
+        out = appendCodeUnit(unit, out);
+        i = 1;
+    }
+
+    while (i + 2 <= length) {
+#ifdef NN_SIMD_SSE2
+        // Narrow 8 code units at a time as long as they are all ASCII
+        if (pendingHighSurrogate == 0 && !atStart) {
+            while (i + 16 <= length) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+
+                if (kind == Utf16BE) {
+                    block = _mm_or_si128(_mm_slli_epi16(block, 8), _mm_srli_epi16(block, 8));
+                }
+
+                const __m128i nonAscii = _mm_and_si128(block, _mm_set1_epi16(static_cast<short>(0xFF80)));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonAscii, _mm_setzero_si128())) != 0xFFFF) {
+                    break;
+                }
+
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(block, block));
+                out += 8;
+                i += 16;
+            }
+
+            if (i + 2 > length) {
+                break;
+            }
+        }
+#endif
+
+        const char16_t unit = kind == Utf16LE ? (data[i] | (data[i + 1] << 8)) : ((data[i] << 8) | data[i + 1]);
+
+        out = appendCodeUnit(unit, out);
+        i += 2;
+    }
+
+    // Odd byte out, keep it for the next chunk
+    if (i < length) {
+        pendingByte = data[i];
+    }
+
+    return out;
+}
+
+char *Utf8Transcoder::appendCodeUnit(char16_t unit, char *out)
+{
+    // QTextCodec drops the BOM so do the same
+    if (atStart) {
+        atStart = false;
+
+        if (unit == 0xFEFF) {
+            return out;
+        }
+    }
+
+    if (pendingHighSurrogate != 0) {
+        if (unit >= 0xDC00 && unit <= 0xDFFF) {
+            const uint codePoint = 0x10000 + ((pendingHighSurrogate - 0xD800) << 10) + (unit - 0xDC00);
+
+            pendingHighSurrogate = 0;
+            return appendCodePoint(codePoint, out);
+        }
+
+        // The high surrogate was never finished
+        pendingHighSurrogate = 0;
+        out = appendReplacement(out);
+    }
+
+    if (unit >= 0xD800 && unit <= 0xDBFF) {
+        pendingHighSurrogate = unit;
+        return out;
+    }
+    else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+        return appendReplacement(out);
+    }
+
+    return appendCodePoint(unit, out);
+}
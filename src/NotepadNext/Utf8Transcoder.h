@@ -0,0 +1,70 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef UTF8TRANSCODER_H
+#define UTF8TRANSCODER_H
+
+#include <QByteArray>
+
+class QTextCodec;
+
+
+// Streaming conversion from UTF-16 and single byte code pages straight to UTF-8, without going through
+// a QString. Partial characters at the end of a chunk are held on to until the next one, the same as
+// QTextCodec::ConverterState.
+class Utf8Transcoder
+{
+public:
+    explicit Utf8Transcoder(const QTextCodec *codec);
+
+    // Not every codec can be handled, if not then QTextCodec needs to be used instead
+    bool isValid() const { return kind != Unsupported; }
+
+    // Replaces the contents of output with the converted data
+    void transcode(const char *data, qint64 length, QByteArray &output);
+
+    // Flushes anything left over (e.g. a dangling surrogate) as replacement characters
+    void finish(QByteArray &output);
+
+private:
+    enum Kind {
+        Unsupported,
+        Utf16LE,
+        Utf16BE,
+        SingleByte,
+    };
+
+    void buildSingleByteTable(const QTextCodec *codec);
+
+    char *transcodeUtf16(const unsigned char *data, qint64 length, char *out);
+    char *transcodeSingleByte(const unsigned char *data, qint64 length, char *out);
+    char *appendCodeUnit(char16_t unit, char *out);
+
+    Kind kind = Unsupported;
+
+    // UTF-8 encoding of each byte for single byte code pages
+    char table[256][3];
+    quint8 tableLength[256];
+
+    bool atStart = true;
+    int pendingByte = -1;
+    char16_t pendingHighSurrogate = 0;
+};
+
+#endif // UTF8TRANSCODER_H
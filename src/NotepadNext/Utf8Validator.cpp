@@ -0,0 +1,338 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "Utf8Validator.h"
+#include "SimdHelpers.h"
+
+#include <QtAlgorithms>
+
+#include <cstring>
+
+
+namespace {
+
+typedef qint64 (*AsciiPrefixFunction)(const unsigned char *data, qint64 length);
+typedef bool (*ValidateFunction)(const unsigned char *data, qint64 length);
+
+qint64 asciiPrefixScalar(const unsigned char *data, qint64 length)
+{
+    qint64 i = 0;
+
+    // Check a word at a time
+    for (; i + 8 <= length; i += 8) {
+        quint64 word;
+        memcpy(&word, data + i, sizeof(word));
+
+        if (word & Q_UINT64_C(0x8080808080808080)) {
+            break;
+        }
+    }
+
+    while (i < length && data[i] < 0x80) {
+        ++i;
+    }
+
+    return i;
+}
+
+#ifdef NN_SIMD_SSE2
+qint64 asciiPrefixSse2(const unsigned char *data, qint64 length)
+{
+    qint64 i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const int mask = _mm_movemask_epi8(block);
+
+        if (mask != 0) {
+            return i + qCountTrailingZeroBits(static_cast<quint32>(mask));
+        }
+    }
+
+    return i + asciiPrefixScalar(data + i, length - i);
+}
+#endif
+
+inline bool isContinuation(unsigned char c)
+{
+    return (c & 0xC0) == 0x80;
+}
+
+// Returns the length of the multi-byte sequence starting at data, or 0 if it is not valid
+inline int sequenceLength(const unsigned char *data, qint64 remaining)
+{
+    const unsigned char lead = data[0];
+
+    if (lead < 0xC2) {
+        // Stray continuation byte or an overlong 2 byte form
+        return 0;
+    }
+    else if (lead < 0xE0) {
+        return (remaining >= 2 && isContinuation(data[1])) ? 2 : 0;
+    }
+    else if (lead < 0xF0) {
+        if (remaining < 3) {
+            return 0;
+        }
+
+        // Reject overlong forms and UTF-16 surrogates
+        const unsigned char low = lead == 0xE0 ? 0xA0 : 0x80;
+        const unsigned char high = lead == 0xED ? 0x9F : 0xBF;
+
+        return (data[1] >= low && data[1] <= high && isContinuation(data[2])) ? 3 : 0;
+    }
+    else if (lead < 0xF5) {
+        if (remaining < 4) {
+            return 0;
+        }
+
+        // Reject overlong forms and anything above U+10FFFF
+        const unsigned char low = lead == 0xF0 ? 0x90 : 0x80;
+        const unsigned char high = lead == 0xF4 ? 0x8F : 0xBF;
+
+        return (data[1] >= low && data[1] <= high && isContinuation(data[2]) && isContinuation(data[3])) ? 4 : 0;
+    }
+
+    return 0;
+}
+
+// Skips runs of ASCII with asciiPrefix and checks the multi-byte sequences in between one at a time
+inline bool validateSequences(const unsigned char *data, qint64 length, AsciiPrefixFunction asciiPrefix)
+{
+    qint64 i = 0;
+
+    while (i < length) {
+        i += asciiPrefix(data + i, length - i);
+
+        // Validate the non-ASCII run before going back to the fast path
+        while (i < length && data[i] >= 0x80) {
+            const int sequence = sequenceLength(data + i, length - i);
+
+            if (sequence == 0) {
+                return false;
+            }
+
+            i += sequence;
+        }
+    }
+
+    return true;
+}
+
+#ifndef NN_SIMD_SSE2
+bool validateScalar(const unsigned char *data, qint64 length)
+{
+    return validateSequences(data, length, asciiPrefixScalar);
+}
+#else
+// SSE2 has no byte shuffle to do the table lookups below, so it only speeds up the ASCII
+bool validateSse2(const unsigned char *data, qint64 length)
+{
+    return validateSequences(data, length, asciiPrefixSse2);
+}
+#endif
+
+#ifdef NN_SIMD_AVX2
+// Checks 32 bytes at a time without branching on the content, using the lookup method from Keiser and
+// Lemire's "Validating UTF-8 In Less Than One Instruction Per Byte". Every byte is classified together with
+// the byte before it using three 16 entry tables, indexed by the high and low nibble of the previous byte and
+// the high nibble of the current one. Each bit in the table entries stands for one kind of error, so a pair
+// of bytes is invalid if the same bit is set in all three. Bytes that have to be the 3rd or 4th byte of a
+// sequence are checked separately by looking two and three bytes back.
+const quint8 TOO_SHORT = 1 << 0;    // A lead byte not followed by a continuation byte
+const quint8 TOO_LONG = 1 << 1;     // A continuation byte after ASCII
+const quint8 OVERLONG_3 = 1 << 2;   // 11100000 100_____
+const quint8 TOO_LARGE = 1 << 3;    // Above U+10FFFF
+const quint8 SURROGATE = 1 << 4;    // 11101101 101_____
+const quint8 OVERLONG_2 = 1 << 5;   // 1100000_ 10______
+const quint8 TOO_LARGE_1000 = 1 << 6;
+const quint8 OVERLONG_4 = 1 << 6;   // 11110000 1000____
+const quint8 TWO_CONTS = 1 << 7;    // Two continuation bytes in a row, only valid within 3 and 4 byte sequences
+const quint8 CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+NN_TARGET_AVX2 inline __m256i lookup16(__m256i indices, quint8 t0, quint8 t1, quint8 t2, quint8 t3, quint8 t4, quint8 t5, quint8 t6, quint8 t7,
+                                       quint8 t8, quint8 t9, quint8 t10, quint8 t11, quint8 t12, quint8 t13, quint8 t14, quint8 t15)
+{
+    const __m256i table = _mm256_setr_epi8(t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15,
+                                           t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15);
+    return _mm256_shuffle_epi8(table, indices);
+}
+
+NN_TARGET_AVX2 inline __m256i highNibbles(__m256i bytes)
+{
+    return _mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0F));
+}
+
+// The block shifted back by N bytes, with the end of the previous block shifted in
+template<int N>
+NN_TARGET_AVX2 inline __m256i previousBytes(__m256i block, __m256i previousBlock)
+{
+    return _mm256_alignr_epi8(block, _mm256_permute2x128_si256(previousBlock, block, 0x21), 16 - N);
+}
+
+NN_TARGET_AVX2 inline __m256i checkSpecialCases(__m256i block, __m256i previous1)
+{
+    const __m256i byte1High = lookup16(highNibbles(previous1),
+        // 0_______ ________
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        // 10______ ________
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        // 1100____ ________
+        TOO_SHORT | OVERLONG_2,
+        // 1101____ ________
+        TOO_SHORT,
+        // 1110____ ________
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        // 1111____ ________
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+
+    const __m256i byte1Low = lookup16(_mm256_and_si256(previous1, _mm256_set1_epi8(0x0F)),
+        // ____0000 ________
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        // ____0001 ________
+        CARRY | OVERLONG_2,
+        // ____001_ ________
+        CARRY, CARRY,
+        // ____0100 ________
+        CARRY | TOO_LARGE,
+        // ____0101 ________ and up
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        // ____1101 ________
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000);
+
+    const __m256i byte2High = lookup16(highNibbles(block),
+        // ________ 0_______
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        // ________ 1000____
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        // ________ 1001____
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        // ________ 101_____
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        // ________ 11______
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    return _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+}
+
+NN_TARGET_AVX2 inline __m256i checkBlock(__m256i block, __m256i previousBlock)
+{
+    const __m256i previous1 = previousBytes<1>(block, previousBlock);
+    const __m256i specialCases = checkSpecialCases(block, previous1);
+
+    // Only 111_____ two bytes back or 1111____ three bytes back end up with the high bit set
+    const __m256i previous2 = previousBytes<2>(block, previousBlock);
+    const __m256i previous3 = previousBytes<3>(block, previousBlock);
+    const __m256i isThirdByte = _mm256_subs_epu8(previous2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    const __m256i isFourthByte = _mm256_subs_epu8(previous3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    const __m256i mustBeContinuation = _mm256_and_si256(_mm256_or_si256(isThirdByte, isFourthByte), _mm256_set1_epi8(static_cast<char>(0x80)));
+
+    // Two continuation bytes in a row are an error exactly when they were not expected
+    return _mm256_xor_si256(mustBeContinuation, specialCases);
+}
+
+// Non-zero if the block ends part way through a sequence, which is fine as long as the next block finishes it
+NN_TARGET_AVX2 inline __m256i isIncomplete(__m256i block)
+{
+    const __m256i maximum = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                             -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                             static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+    return _mm256_subs_epu8(block, maximum);
+}
+
+struct Avx2State
+{
+    __m256i error;
+    __m256i previousBlock;
+    __m256i previousIncomplete;
+};
+
+NN_TARGET_AVX2 inline void processBlock(Avx2State &state, __m256i block)
+{
+    if (_mm256_movemask_epi8(block) == 0) {
+        // All ASCII, so the only possible error is a sequence cut off at the end of the previous block
+        state.error = _mm256_or_si256(state.error, state.previousIncomplete);
+    }
+    else {
+        state.error = _mm256_or_si256(state.error, checkBlock(block, state.previousBlock));
+        state.previousIncomplete = isIncomplete(block);
+    }
+
+    state.previousBlock = block;
+}
+
+NN_TARGET_AVX2 bool validateAvx2(const unsigned char *data, qint64 length)
+{
+    Avx2State state = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+    qint64 i = 0;
+
+    for (; i + 32 <= length; i += 32) {
+        processBlock(state, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)));
+
+        // Stop early on errors every so often rather than checking every block
+        if ((i & 0xFFFF) == 0 && !_mm256_testz_si256(state.error, state.error)) {
+            return false;
+        }
+    }
+
+    // The rest is padded with ASCII, which also shows up any sequence cut off by the end of the data
+    if (i < length) {
+        unsigned char tail[32] = {};
+        memcpy(tail, data + i, static_cast<size_t>(length - i));
+        processBlock(state, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tail)));
+    }
+
+    const __m256i error = _mm256_or_si256(state.error, state.previousIncomplete);
+
+    return _mm256_testz_si256(error, error) != 0;
+}
+#endif
+
+ValidateFunction selectValidate()
+{
+#ifdef NN_SIMD_AVX2
+    if (SimdHelpers::hasAvx2()) {
+        return validateAvx2;
+    }
+#endif
+#ifdef NN_SIMD_SSE2
+    return validateSse2;
+#else
+    return validateScalar;
+#endif
+}
+
+}
+
+bool Utf8Validator::isValid(const char *data, qint64 length)
+{
+    static const ValidateFunction validate = selectValidate();
+
+    return validate(reinterpret_cast<const unsigned char *>(data), length);
+}
@@ -0,0 +1,33 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef UTF8VALIDATOR_H
+#define UTF8VALIDATOR_H
+
+#include <QtGlobal>
+
+namespace Utf8Validator
+{
+    // Strict RFC 3629 validation (no overlong forms, surrogates, or code points above U+10FFFF).
+    // With AVX2 everything is checked 32 bytes at a time using table lookups, with only SSE2 just
+    // runs of ASCII are skipped 16 bytes at a time.
+    bool isValid(const char *data, qint64 length);
+}
+
+#endif // UTF8VALIDATOR_H
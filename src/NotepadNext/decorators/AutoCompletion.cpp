@@ -43,15 +43,15 @@ void AutoCompletion::notify(const NotificationData *pscn)
 
 void AutoCompletion::showAutoCompletion()
 {
-    int curPos = editor->currentPos();
-    int startPos = editor->wordStartPosition(curPos, true);
-    int endPos = editor->wordEndPosition(curPos, true);
+    Sci_Position curPos = editor->currentPos();
+    Sci_Position startPos = editor->wordStartPosition(curPos, true);
+    Sci_Position endPos = editor->wordEndPosition(curPos, true);
 
     // Need a minimum number of characters to trigger auto completion
     if ((curPos - startPos) < 3)
         return;
 
-    const QByteArray current_word = editor->get_text_range(startPos, curPos);
+    const QByteArray current_word = editor->textRangeFull(startPos, curPos);
     const QByteArray regex = "\\b" + current_word + "[\\w]*";
     QSet<QByteArray> words;
 
@@ -60,16 +60,16 @@ void AutoCompletion::showAutoCompletion()
     // Don't want to find the word that's currently being typed
 
     // Find everything before this word
-    editor->forEachMatchInRange(regex, [&](int start, int end) {
-        words.insert(editor->get_text_range(start, end));
+    editor->forEachMatchInRange(regex, [&](Sci_Position start, Sci_Position end) {
+        words.insert(editor->textRangeFull(start, end));
         return end;
     }, { 0, startPos});
 
     // Find everything after this word
-    editor->forEachMatchInRange(regex, [&](int start, int end) {
-        words.insert(editor->get_text_range(start, end));
+    editor->forEachMatchInRange(regex, [&](Sci_Position start, Sci_Position end) {
+        words.insert(editor->textRangeFull(start, end));
         return end;
-    }, { endPos, (Sci_PositionCR)editor->length()});
+    }, { endPos, editor->length()});
 
     if (!words.isEmpty()) {
         editor->autoCShow(current_word.length(), words.values().join(' '));
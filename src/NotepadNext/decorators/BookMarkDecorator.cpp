@@ -36,7 +36,7 @@ BookMarkDecorator::BookMarkDecorator(ScintillaNext *editor) :
     editor->setMarginSensitiveN(MARGIN, true);
 }
 
-void BookMarkDecorator::toggleBookmark(int line)
+void BookMarkDecorator::toggleBookmark(Sci_Position line)
 {
     if (editor->markerGet(line) & (1 << MARK_BOOKMARK)) {
         // The marker can be set multiple times, so keep deleting it till it is no longer set
@@ -49,9 +49,9 @@ void BookMarkDecorator::toggleBookmark(int line)
     }
 }
 
-int BookMarkDecorator::nextBookmarkAfter(int line)
+Sci_Position BookMarkDecorator::nextBookmarkAfter(Sci_Position line)
 {
-    int nextMarkedLine = editor->markerNext(line, 1 << MARK_BOOKMARK);
+    Sci_Position nextMarkedLine = editor->markerNext(line, 1 << MARK_BOOKMARK);
 
     if (nextMarkedLine == -1) {
         return editor->markerNext(0, 1 << MARK_BOOKMARK);
@@ -61,9 +61,9 @@ int BookMarkDecorator::nextBookmarkAfter(int line)
     }
 }
 
-int BookMarkDecorator::previousBookMarkBefore(int line)
+Sci_Position BookMarkDecorator::previousBookMarkBefore(Sci_Position line)
 {
-    int prevMarkedLine = editor->markerPrevious(line, 1 << MARK_BOOKMARK);
+    Sci_Position prevMarkedLine = editor->markerPrevious(line, 1 << MARK_BOOKMARK);
 
     if (prevMarkedLine == -1) {
         return editor->markerPrevious(editor->lineCount(), 1 << MARK_BOOKMARK);
@@ -78,11 +78,22 @@ void BookMarkDecorator::clearBookmarks()
     editor->markerDeleteAll(MARK_BOOKMARK);
 }
 
+QList<Sci_Position> BookMarkDecorator::bookmarkedLines() const
+{
+    QList<Sci_Position> lines;
+
+    for (Sci_Position line = editor->markerNext(0, 1 << MARK_BOOKMARK); line != -1; line = editor->markerNext(line + 1, 1 << MARK_BOOKMARK)) {
+        lines.append(line);
+    }
+
+    return lines;
+}
+
 void BookMarkDecorator::notify(const Scintilla::NotificationData *pscn)
 {
     if (pscn->nmhdr.code == Scintilla::Notification::MarginClick) {
         if (pscn->margin == MARGIN) {
-            int line = editor->lineFromPosition(pscn->position);
+            Sci_Position line = editor->lineFromPosition(pscn->position);
             toggleBookmark(line);
         }
     }
@@ -29,10 +29,11 @@ class BookMarkDecorator : public EditorDecorator
 public:
     BookMarkDecorator(ScintillaNext *editor);
 
-    void toggleBookmark(int line);
-    int nextBookmarkAfter(int line);
-    int previousBookMarkBefore(int line);
+    void toggleBookmark(Sci_Position line);
+    Sci_Position nextBookmarkAfter(Sci_Position line);
+    Sci_Position previousBookMarkBefore(Sci_Position line);
     void clearBookmarks();
+    QList<Sci_Position> bookmarkedLines() const;
 
 public slots:
     void notify(const Scintilla::NotificationData *pscn) override;
@@ -65,7 +65,7 @@ void BraceMatch::doHighlighting()
     const Sci_Position pos = static_cast<Sci_Position>(editor->currentPos());
 
     // Check the character before the caret first
-    int match = editor->braceMatch(pos - 1, 0);
+    Sci_Position match = editor->braceMatch(pos - 1, 0);
 
     if (match != INVALID_POSITION) {
          editor->braceHighlight(pos - 1, match);
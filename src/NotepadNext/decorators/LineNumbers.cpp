@@ -21,7 +21,7 @@
 
 using namespace Scintilla;
 
-static inline int countDigits(quint32 x)
+static inline int countDigits(quint64 x)
 {
     // Ugly but efficient
     return (x < 10 ? 1 :
@@ -33,7 +33,8 @@ static inline int countDigits(quint32 x)
            (x < 10000000 ? 7 :
            (x < 100000000 ? 8 :
            (x < 1000000000 ? 9 :
-           10)))))))));
+           (x < 10000000000 ? 10 :
+           11))))))))));
 }
 
 LineNumbers::LineNumbers(ScintillaNext *editor) :
@@ -53,7 +54,7 @@ LineNumbers::LineNumbers(ScintillaNext *editor) :
 
 void LineNumbers::adjustMarginWidth()
 {
-    int lineCount = editor->lineCount();
+    Sci_Position lineCount = editor->lineCount();
     int pixelWidth = 8 + (qMax(countDigits(lineCount), 3)) * editor->textWidth(STYLE_LINENUMBER, "8");
     editor->setMarginWidthN(0, pixelWidth);
 }
@@ -53,24 +53,24 @@ void SmartHighlighter::highlightCurrentView()
     }
 
     const int mainSelection = editor->mainSelection();
-    const int selectionStart = editor->selectionNStart(mainSelection);
-    const int selectionEnd = editor->selectionNEnd(mainSelection);
+    const Sci_Position selectionStart = editor->selectionNStart(mainSelection);
+    const Sci_Position selectionEnd = editor->selectionNEnd(mainSelection);
 
     // Make sure the current selection is valid
     if (selectionStart == selectionEnd) {
         return;
     }
 
-    const int curPos = editor->currentPos();
-    const int wordStart = editor->wordStartPosition(curPos, true);
-    const int wordEnd = editor->wordEndPosition(wordStart, true);
+    const Sci_Position curPos = editor->currentPos();
+    const Sci_Position wordStart = editor->wordStartPosition(curPos, true);
+    const Sci_Position wordEnd = editor->wordEndPosition(wordStart, true);
 
     // Make sure the selection is on word boundaries
     if (wordStart == wordEnd || wordStart != selectionStart || wordEnd != selectionEnd) {
         return;
     }
 
-    const QByteArray selText = editor->get_text_range(selectionStart, selectionEnd);
+    const QByteArray selText = editor->textRangeFull(selectionStart, selectionEnd);
 
     // TODO: Handle large files. By default Notepad++ only monitors the text on screen. However,
     // that will not work when using a highlighted scroll bar. Testing with small files seems to
@@ -84,10 +84,10 @@ void SmartHighlighter::highlightCurrentView()
 
     // TODO: skip hidden or folded lines?
 
-    Sci_TextToFind ttf {{0, (Sci_PositionCR)editor->length()}, selText.constData(), {-1, -1}};
+    Sci_TextToFindFull ttf {{0, editor->length()}, selText.constData(), {-1, -1}};
     const int flags = SCFIND_MATCHCASE | SCFIND_WHOLEWORD;
 
-    while (editor->send(SCI_FINDTEXT, flags, (sptr_t)&ttf) != -1) {
+    while (editor->findTextFull(flags, &ttf) != -1) {
         editor->indicatorFillRange(ttf.chrgText.cpMin, ttf.chrgText.cpMax - ttf.chrgText.cpMin);
         ttf.chrg.cpMin = ttf.chrgText.cpMax;
     }
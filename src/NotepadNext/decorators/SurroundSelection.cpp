@@ -75,12 +75,12 @@ void SurroundSelection::notify(const Scintilla::NotificationData *pscn)
 
 void SurroundSelection::surroundSelections(const char ch1, const char ch2)
 {
-    std::vector<std::pair<int, int>> selections;
+    std::vector<std::pair<Sci_Position, Sci_Position>> selections;
 
     int num = editor->selections();
     for (int i = 0; i < num; ++i) {
-        int start = editor->selectionNStart(i);
-        int end = editor->selectionNEnd(i);
+        Sci_Position start = editor->selectionNStart(i);
+        Sci_Position end = editor->selectionNEnd(i);
 
         if (start != end /* && editor.LineFromPosition(start) == editor.LineFromPosition(end) */)
             selections.push_back(std::make_pair(start, end));
@@ -92,7 +92,7 @@ void SurroundSelection::surroundSelections(const char ch1, const char ch2)
     editor->beginUndoAction();
     editor->clearSelections();
 
-    int offset = 0;
+    Sci_Position offset = 0;
     for (size_t i = 0; i < selections.size(); ++i) {
         const auto &selection = selections[i];
         editor->setTargetRange(selection.first + offset, selection.second + offset);
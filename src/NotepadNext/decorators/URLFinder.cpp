@@ -51,7 +51,7 @@ void URLFinder::findURLs()
     editor->setIndicatorCurrent(indicator);
     editor->indicatorClearRange(0, editor->length());
 
-    int currentLine = editor->docLineFromVisible(editor->firstVisibleLine());
+    Sci_Position currentLine = editor->docLineFromVisible(editor->firstVisibleLine());
     int linesLeftToProcess = editor->linesOnScreen();
     const int flags = SCFIND_REGEXP;
 
@@ -62,14 +62,14 @@ void URLFinder::findURLs()
             continue;
         }
 
-        const int startPos = editor->positionFromLine(currentLine);
-        const int endPos = editor->lineEndPosition(currentLine);
+        const Sci_Position startPos = editor->positionFromLine(currentLine);
+        const Sci_Position endPos = editor->lineEndPosition(currentLine);
         QByteArray reg = QByteArrayLiteral(R"(\bhttps?://[-a-zA-Z0-9@:%._\+~#=]{1,256}\.[a-zA-Z0-9()]{1,6}\b(?:[-a-zA-Z0-9()@:%_\+.~#?&\/=]*))");
 
-        Sci_TextToFind ttf {{startPos, (Sci_PositionCR)endPos}, reg.constData(), {-1, -1}};
-        while (editor->send(SCI_FINDTEXT, flags, (sptr_t)&ttf) != -1) {
-            const int startUrl = ttf.chrgText.cpMin;
-            int endUrl = ttf.chrgText.cpMax;
+        Sci_TextToFindFull ttf {{startPos, endPos}, reg.constData(), {-1, -1}};
+        while (editor->send(SCI_FINDTEXTFULL, flags, (sptr_t)&ttf) != -1) {
+            const Sci_Position startUrl = ttf.chrgText.cpMin;
+            Sci_Position endUrl = ttf.chrgText.cpMax;
 
             // Though technically certain characters are allowed in the URL such as brackets, parenthesis, etc
             // this adds a bit of logic to trim off the end character based on if something is in front if it, for example
@@ -127,13 +127,13 @@ void URLFinder::notify(const Scintilla::NotificationData *pscn)
 
         if (indicators & (1 << indicator)) {
 
-            const int indicatorStart = editor->indicatorStart(indicator, pscn->position);
-            const int indicatorEnd = editor->indicatorEnd(indicator, pscn->position);
+            const Sci_Position indicatorStart = editor->indicatorStart(indicator, pscn->position);
+            const Sci_Position indicatorEnd = editor->indicatorEnd(indicator, pscn->position);
 
-            QUrl url(editor->get_text_range(indicatorStart, indicatorEnd));
+            QUrl url(editor->textRangeFull(indicatorStart, indicatorEnd));
 
             if (url.isValid()) {
-                qInfo("URL hotspot click: \"%s\"", editor->get_text_range(indicatorStart, indicatorEnd).constData());
+                qInfo("URL hotspot click: \"%s\"", editor->textRangeFull(indicatorStart, indicatorEnd).constData());
                 QDesktopServices::openUrl(url);
             }
             else {
@@ -72,13 +72,13 @@ void ColumnEditorDialog::insertTextStartingAtCurrentColumn(const std::function<Q
     ScintillaNext *editor = parent->currentEditor();
 
     if (editor->selectionMode() == SC_SEL_STREAM && editor->selections() == 1 && editor->selectionEmpty()) {
-        const int currentPos = editor->selectionNCaret(0);
+        const Sci_Position currentPos = editor->selectionNCaret(0);
 
         // If the cursor is in virtual space, the call to selectionNCaretVirtualSpace will be > 0
         const int currentColumn = editor->column(currentPos) + editor->selectionNCaretVirtualSpace(0);
 
         const UndoAction ua(editor);
-        for (int line = editor->lineFromPosition(currentPos); line < editor->lineCount(); ++line) {
+        for (Sci_Position line = editor->lineFromPosition(currentPos); line < editor->lineCount(); ++line) {
             insertTextAtColumn(editor, line, currentColumn, f());
         }
     }
@@ -89,8 +89,8 @@ void ColumnEditorDialog::insertTextStartingAtCurrentColumn(const std::function<Q
 
         const UndoAction ua(editor);
         for(int selection = 0; selection < totalSelections; ++selection) {
-            const int start = editor->selectionNStart(selection) + editor->selectionNStartVirtualSpace(selection);
-            const int end = editor->selectionNEnd(selection) + editor->selectionNEndVirtualSpace(selection);
+            const Sci_Position start = editor->selectionNStart(selection) + editor->selectionNStartVirtualSpace(selection);
+            const Sci_Position end = editor->selectionNEnd(selection) + editor->selectionNEndVirtualSpace(selection);
 
             editor->setTargetRange(start, end);
             editor->replaceTarget(-1, f().toUtf8().constData());
@@ -98,9 +98,9 @@ void ColumnEditorDialog::insertTextStartingAtCurrentColumn(const std::function<Q
     }
 }
 
-void ColumnEditorDialog::insertTextAtColumn(ScintillaNext *editor, int line, int column, const QString &str)
+void ColumnEditorDialog::insertTextAtColumn(ScintillaNext *editor, Sci_Position line, int column, const QString &str)
 {
-    const int lineEndPosition = editor->lineEndPosition(line);
+    const Sci_Position lineEndPosition = editor->lineEndPosition(line);
     const int lineEndColumn = editor->column(lineEndPosition);
 
     // If the line does not end past the needed column, then use the left over as virtual space
@@ -111,7 +111,7 @@ void ColumnEditorDialog::insertTextAtColumn(ScintillaNext *editor, int line, int
         editor->setTargetEndVirtualSpace(column - lineEndColumn);
     }
     else {
-        const int pos = editor->findColumn(line, column);
+        const Sci_Position pos = editor->findColumn(line, column);
 
         editor->setTargetRange(pos, pos);
     }
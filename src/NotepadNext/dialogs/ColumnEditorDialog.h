@@ -36,7 +36,7 @@ public:
     ~ColumnEditorDialog();
 
     void insertTextStartingAtCurrentColumn(const std::function <QString (void)>& f);
-    void insertTextAtColumn(ScintillaNext *editor, int line, int column, const QString &str);
+    void insertTextAtColumn(ScintillaNext *editor, Sci_Position line, int column, const QString &str);
 
 private:
     Ui::ColumnEditorDialog *ui;
@@ -21,12 +21,15 @@
 #include "ui_FindReplaceDialog.h"
 
 #include <QSettings>
+#include <QSharedPointer>
 #include <QStatusBar>
 #include <QLineEdit>
 #include <QKeyEvent>
 
 #include "ScintillaNext.h"
 #include "MainWindow.h"
+#include "ParallelFinder.h"
+#include "PagedFileView.h"
 
 
 static void convertToExtended(QString &str)
@@ -99,8 +102,15 @@ FindReplaceDialog::FindReplaceDialog(ISearchResultsHandler *searchResults, MainW
     connect(ui->buttonFind, &QPushButton::clicked, this, &FindReplaceDialog::find);
     connect(ui->buttonCount, &QPushButton::clicked, this, &FindReplaceDialog::count);
     connect(ui->buttonFindAllInCurrent, &QPushButton::clicked, this, [=]() {
+        cancelFindAllInDocuments();
         prepareToPerformSearch();
 
+        // Only the lines being viewed are in the editor, so the results would be incomplete
+        if (PagedFileView::forEditor(editor)) {
+            showMessage(tr("Find All is not available for paged files, use Find Next instead."), "red");
+            return;
+        }
+
         searchResultsHandler->newSearch(findString());
 
         findAllInCurrentDocument();
@@ -110,15 +120,21 @@ FindReplaceDialog::FindReplaceDialog(ISearchResultsHandler *searchResults, MainW
         close();
     });
     connect(ui->buttonFindAllInDocuments, &QPushButton::clicked, this, [=]() {
+        cancelFindAllInDocuments();
         prepareToPerformSearch();
 
         searchResultsHandler->newSearch(findString());
 
-        findAllInDocuments();
-
-        searchResultsHandler->completeSearch();
+        // The search is completed once the last document has been searched
+        const int skipped = findAllInDocuments();
 
-        close();
+        // Stay open so it is clear why those files have no results
+        if (skipped > 0) {
+            showMessage(tr("%Ln paged file(s) could not be searched, use Find Next on them instead.", "", skipped), "red");
+        }
+        else {
+            close();
+        }
     });
     connect(ui->buttonReplace, &QPushButton::clicked, this, &FindReplaceDialog::replace);
     connect(ui->buttonReplaceAll, &QPushButton::clicked, this, &FindReplaceDialog::replaceAll);
@@ -131,18 +147,55 @@ FindReplaceDialog::FindReplaceDialog(ISearchResultsHandler *searchResults, MainW
             convertToExtended(replaceText);
         }
 
-        int count = 0;
+        auto count = QSharedPointer<int>::create(0);
+        // Starts at one for the loop below, so the message can't be shown before every editor was looked at
+        auto remaining = QSharedPointer<int>::create(1);
+
+        auto editorDone = [=]() {
+            if (--*remaining == 0) {
+                showMessage(tr("Replaced %Ln matches", "", *count), "green");
+            }
+        };
+
         ScintillaNext *current_editor = editor;
         MainWindow *window = qobject_cast<MainWindow *>(parent());
 
         for(ScintillaNext *editor : window->editors()) {
+            // Placeholder tabs from the session haven't been read yet. Rather than reading them one at a time on
+            // this thread, start them all loading and replace in each one as it finishes.
+            if (editor->isLoading()) {
+                // The search settings may have changed by the time it is loaded
+                Finder loadedFinder(*finder);
+                loadedFinder.setEditor(editor);
+
+                auto waiting = QSharedPointer<bool>::create(true);
+                ++*remaining;
+
+                connect(editor, &ScintillaNext::loadFinished, this, [=](bool success) mutable {
+                    if (*waiting) {
+                        *waiting = false;
+                        *count += success ? loadedFinder.replaceAll(replaceText) : 0;
+                        editorDone();
+                    }
+                });
+                connect(editor, &QObject::destroyed, this, [=]() {
+                    if (*waiting) {
+                        *waiting = false;
+                        editorDone();
+                    }
+                });
+
+                editor->ensureLoaded();
+                continue;
+            }
+
             setEditor(editor);
-            count += finder->replaceAll(replaceText);
+            *count += finder->replaceAll(replaceText);
         }
 
         setEditor(current_editor);
 
-        showMessage(tr("Replaced %Ln matches", "", count), "green");
+        editorDone();
     });
     connect(ui->buttonClose, &QPushButton::clicked, this, &FindReplaceDialog::close);
 
@@ -222,7 +275,13 @@ void FindReplaceDialog::find()
 
     prepareToPerformSearch();
 
-    Sci_CharacterRange range = finder->findNext();
+    // Paged files are searched on disk in the background
+    if (PagedFileView *view = PagedFileView::forEditor(editor)) {
+        findInPagedFile(view);
+        return;
+    }
+
+    Sci_CharacterRangeFull range = finder->findNext();
 
     if (ScintillaNext::isRangeValid(range)) {
         if (finder->didLatestSearchWrapAround()) {
@@ -241,6 +300,41 @@ void FindReplaceDialog::find()
     }
 }
 
+void FindReplaceDialog::findInPagedFile(PagedFileView *view)
+{
+    if (computeSearchFlags() & (SCFIND_REGEXP | SCFIND_WHOLEWORD)) {
+        showMessage(tr("Only plain text can be searched for in paged files."), "red");
+        return;
+    }
+
+    if (view->isSearching()) {
+        return;
+    }
+
+    QString findText = findString();
+    if (ui->radioExtendedSearch->isChecked()) {
+        convertToExtended(findText);
+    }
+
+    connect(view, &PagedFileView::searchFinished, this, &FindReplaceDialog::pagedSearchFinished, Qt::UniqueConnection);
+
+    showMessage(tr("Searching..."), "black");
+    view->findNext(findText.toUtf8(), computeSearchFlags(), ui->checkBoxWrapAround->isChecked());
+}
+
+void FindReplaceDialog::pagedSearchFinished(bool found, bool wrapped)
+{
+    if (!found) {
+        showMessage(tr("No matches found."), "red");
+    }
+    else if (wrapped) {
+        showMessage(tr("The end of the document has been reached. Found 1st occurrence from the top."), "green");
+    }
+    else {
+        statusBar->clearMessage();
+    }
+}
+
 void FindReplaceDialog::findAllInCurrentDocument()
 {
     qInfo(Q_FUNC_INFO);
@@ -250,19 +344,19 @@ void FindReplaceDialog::findAllInCurrentDocument()
     QString text = findString();
 
     finder->setSearchText(text);
-    finder->forEachMatch([&](int start, int end){
+    finder->forEachMatch([&](Sci_Position start, Sci_Position end){
         // Only add the file entry if there was a valid search result
         if (firstMatch) {
             searchResultsHandler->newFileEntry(editor);
             firstMatch = false;
         }
 
-        const int line = editor->lineFromPosition(start);
-        const int lineStartPosition = editor->positionFromLine(line);
-        const int lineEndPosition = editor->lineEndPosition(line);
-        const int startPositionFromBeginning = start - lineStartPosition;
-        const int endPositionFromBeginning = end - lineStartPosition;
-        QString lineText = editor->get_text_range(lineStartPosition, lineEndPosition);
+        const Sci_Position line = editor->lineFromPosition(start);
+        const Sci_Position lineStartPosition = editor->positionFromLine(line);
+        const Sci_Position lineEndPosition = editor->lineEndPosition(line);
+        const Sci_Position startPositionFromBeginning = start - lineStartPosition;
+        const Sci_Position endPositionFromBeginning = end - lineStartPosition;
+        QString lineText = editor->textRangeFull(lineStartPosition, lineEndPosition);
 
         searchResultsHandler->newResultsEntry(lineText, line, startPositionFromBeginning, endPositionFromBeginning);
 
@@ -270,19 +364,50 @@ void FindReplaceDialog::findAllInCurrentDocument()
     });
 }
 
-void FindReplaceDialog::findAllInDocuments()
+int FindReplaceDialog::findAllInDocuments()
 {
     qInfo(Q_FUNC_INFO);
 
-    ScintillaNext *current_editor = editor;
     MainWindow *window = qobject_cast<MainWindow *>(parent());
+    int skipped = 0;
+
+    parallelFinder = new ParallelFinder(findString(), computeSearchFlags(), this);
 
     for(ScintillaNext *editor : window->editors()) {
-        setEditor(editor);
-        findAllInCurrentDocument();
+        // Only the lines being viewed are in the editor, so the results would be incomplete
+        if (PagedFileView::forEditor(editor)) {
+            ++skipped;
+            continue;
+        }
+
+        parallelFinder->addDocument(editor);
     }
 
-    setEditor(current_editor);
+    // The handler is looked up each time since it can change while the search is running
+    connect(parallelFinder, &ParallelFinder::fileFinished, this, [=](ScintillaNext *editor, const QVector<ParallelFinder::Match> &matches) {
+        searchResultsHandler->newFileEntry(editor);
+
+        for (const ParallelFinder::Match &match : matches) {
+            searchResultsHandler->newResultsEntry(match.lineText, match.lineNumber, match.startPositionFromBeginning, match.endPositionFromBeginning);
+        }
+    });
+    connect(parallelFinder, &ParallelFinder::finished, this, [=]() {
+        searchResultsHandler->completeSearch();
+
+        parallelFinder->deleteLater();
+        parallelFinder = Q_NULLPTR;
+    });
+
+    parallelFinder->start();
+
+    return skipped;
+}
+
+void FindReplaceDialog::cancelFindAllInDocuments()
+{
+    if (parallelFinder) {
+        parallelFinder->cancel();
+    }
 }
 
 void FindReplaceDialog::replace()
@@ -297,13 +422,13 @@ void FindReplaceDialog::replace()
         convertToExtended(replaceText);
     }
 
-    Sci_CharacterRange range = finder->replaceSelectionIfMatch(replaceText);
+    Sci_CharacterRangeFull range = finder->replaceSelectionIfMatch(replaceText);
 
     if (ScintillaNext::isRangeValid(range)) {
         showMessage(tr("1 occurrence was replaced"), "blue");
     }
 
-    Sci_CharacterRange next_match = finder->findNext();
+    Sci_CharacterRangeFull next_match = finder->findNext();
 
     if (ScintillaNext::isRangeValid(next_match)) {
         editor->goToRange(next_match);
@@ -337,6 +462,11 @@ void FindReplaceDialog::count()
 
     prepareToPerformSearch();
 
+    if (PagedFileView::forEditor(editor)) {
+        showMessage(tr("Count is not available for paged files."), "red");
+        return;
+    }
+
     int total = finder->count();
 
     showMessage(tr("Found %Ln matches", "", total), "green");
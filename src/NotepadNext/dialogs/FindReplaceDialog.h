@@ -22,6 +22,7 @@
 
 #include <QDialog>
 #include <QEvent>
+#include <QPointer>
 #include <QStatusBar>
 #include <QTabBar>
 
@@ -31,6 +32,8 @@
 
 class ScintillaNext;
 class MainWindow;
+class PagedFileView;
+class ParallelFinder;
 
 namespace Ui {
 class FindReplaceDialog;
@@ -71,7 +74,10 @@ public slots:
 
     void find();
     void findAllInCurrentDocument();
-    void findAllInDocuments();
+    // Searches every open document on the thread pool, the results are passed on as each one finishes.
+    // Paged files are skipped, returns how many there were.
+    int findAllInDocuments();
+    void cancelFindAllInDocuments();
     void count();
     void replace();
     void replaceAll();
@@ -85,9 +91,12 @@ private slots:
 
     void changeTab(int index);
 
+    void pagedSearchFinished(bool found, bool wrapped);
+
 private:
     QString findString();
     void prepareToPerformSearch(bool replace=false);
+    void findInPagedFile(PagedFileView *view);
     void loadSettings();
     void saveSettings();
 
@@ -111,6 +120,7 @@ private:
 
     ISearchResultsHandler *searchResultsHandler;
     Finder *finder;
+    QPointer<ParallelFinder> parallelFinder;
 };
 
 #endif // FINDREPLACEDIALOG_H
@@ -54,6 +54,8 @@
 #include "RecentFilesListManager.h"
 #include "RecentFilesListMenuBuilder.h"
 #include "EditorManager.h"
+#include "LargeFileProfile.h"
+#include "PagedFileView.h"
 
 #include "LuaConsoleDock.h"
 #include "LanguageInspectorDock.h"
@@ -116,7 +118,7 @@ MainWindow::MainWindow(NotepadNextApplication *app) :
     connect(ui->actionCloseAllToLeft, &QAction::triggered, this, &MainWindow::closeAllToLeft);
     connect(ui->actionCloseAllToRight, &QAction::triggered, this, &MainWindow::closeAllToRight);
 
-    connect(ui->actionSave, &QAction::triggered, this, &MainWindow::saveCurrentFile);
+    connect(ui->actionSave, &QAction::triggered, this, &MainWindow::saveCurrentFileInBackground);
     connect(ui->actionSaveAs, &QAction::triggered, this, &MainWindow::saveCurrentFileAsDialog);
     connect(ui->actionSaveCopyAs, &QAction::triggered, this, &MainWindow::saveCopyAsDialog);
     connect(ui->actionSaveAll, &QAction::triggered, this, &MainWindow::saveAll);
@@ -287,10 +289,10 @@ MainWindow::MainWindow(NotepadNextApplication *app) :
     srDock->toggleViewAction()->setShortcut(Qt::Key_F7);
     ui->menuView->addAction(srDock->toggleViewAction());
 
-    connect(srDock, &SearchResultsDock::searchResultActivated, this, [=](ScintillaNext *editor, int lineNumber, int startPositionFromBeginning, int endPositionFromBeginning) {
+    connect(srDock, &SearchResultsDock::searchResultActivated, this, [=](ScintillaNext *editor, Sci_Position lineNumber, Sci_Position startPositionFromBeginning, Sci_Position endPositionFromBeginning) {
         dockedEditor->switchToEditor(editor);
 
-        int linePos = editor->positionFromLine(lineNumber);
+        Sci_Position linePos = editor->positionFromLine(lineNumber);
         editor->goToRange({linePos + startPositionFromBeginning, linePos + endPositionFromBeginning});
         editor->verticalCentreCaret();
 
@@ -327,15 +329,23 @@ MainWindow::MainWindow(NotepadNextApplication *app) :
 
     connect(ui->actionGoToLine, &QAction::triggered, this, [=]() {
         ScintillaNext *editor = currentEditor();
-        const int currentLine = editor->lineFromPosition(editor->currentPos()) + 1;
-        const int maxLine = editor->lineCount();
+        PagedFileView *view = PagedFileView::forEditor(editor);
+        const Sci_Position lineCount = view ? view->lineCount() : editor->lineCount();
+        const Sci_Position line = view ? view->currentLine() : editor->lineFromPosition(editor->currentPos());
+
+        // The dialog only goes as high as an int
+        const int maxLine = static_cast<int>(qMin<Sci_Position>(lineCount, INT_MAX));
+        const int currentLine = static_cast<int>(qMin<Sci_Position>(line + 1, maxLine));
         bool ok;
 
         QInputDialog d = QInputDialog(this);
         Qt::WindowFlags flags = d.windowFlags() & ~Qt::WindowContextHelpButtonHint;
         int lineToGoTo = d.getInt(this, tr("Go to line"), tr("Line Number (1 - %1)").arg(maxLine), currentLine, 1, maxLine, 1, &ok, flags);
 
-        if (ok) {
+        if (ok && view) {
+            view->showLine(lineToGoTo - 1);
+        }
+        else if (ok) {
             editor->ensureVisible(lineToGoTo - 1);
             editor->gotoLine(lineToGoTo - 1);
             editor->verticalCentreCaret();
@@ -347,7 +357,7 @@ MainWindow::MainWindow(NotepadNextApplication *app) :
         BookMarkDecorator *bookMarkDecorator = editor->findChild<BookMarkDecorator*>(QString(), Qt::FindDirectChildrenOnly);
 
         if (bookMarkDecorator && bookMarkDecorator->isEnabled()) {
-            editor->forEachLineInSelection(editor->mainSelection(), [&](int line) {
+            editor->forEachLineInSelection(editor->mainSelection(), [&](Sci_Position line) {
                 bookMarkDecorator->toggleBookmark(line);
             });
         }
@@ -358,8 +368,8 @@ MainWindow::MainWindow(NotepadNextApplication *app) :
         BookMarkDecorator *bookMarkDecorator = editor->findChild<BookMarkDecorator*>(QString(), Qt::FindDirectChildrenOnly);
 
         if (bookMarkDecorator && bookMarkDecorator->isEnabled()) {
-            int currentLine = editor->lineFromPosition(editor->currentPos());
-            int nextBookmarkedLine = bookMarkDecorator->nextBookmarkAfter(currentLine + 1);
+            Sci_Position currentLine = editor->lineFromPosition(editor->currentPos());
+            Sci_Position nextBookmarkedLine = bookMarkDecorator->nextBookmarkAfter(currentLine + 1);
 
             if (nextBookmarkedLine != -1) {
                 editor->ensureVisibleEnforcePolicy(nextBookmarkedLine);
@@ -382,7 +392,7 @@ MainWindow::MainWindow(NotepadNextApplication *app) :
         BookMarkDecorator *bookMarkDecorator = editor->findChild<BookMarkDecorator*>(QString(), Qt::FindDirectChildrenOnly);
 
         if (bookMarkDecorator && bookMarkDecorator->isEnabled()) {
-            for (int line = 0; line < editor->lineCount(); line++) {
+            for (Sci_Position line = 0; line < editor->lineCount(); line++) {
                 bookMarkDecorator->toggleBookmark(line);
             }
         }
@@ -393,8 +403,8 @@ MainWindow::MainWindow(NotepadNextApplication *app) :
         BookMarkDecorator *bookMarkDecorator = editor->findChild<BookMarkDecorator*>(QString(), Qt::FindDirectChildrenOnly);
 
         if (bookMarkDecorator && bookMarkDecorator->isEnabled()) {
-            int currentLine = editor->lineFromPosition(editor->currentPos());
-            int prevBookmarkedLine = bookMarkDecorator->previousBookMarkBefore(currentLine - 1);
+            Sci_Position currentLine = editor->lineFromPosition(editor->currentPos());
+            Sci_Position prevBookmarkedLine = bookMarkDecorator->previousBookMarkBefore(currentLine - 1);
 
             if (prevBookmarkedLine != -1) {
                 editor->ensureVisibleEnforcePolicy(prevBookmarkedLine);
@@ -461,16 +471,22 @@ MainWindow::MainWindow(NotepadNextApplication *app) :
     });
     ui->actionShowIndentGuide->setChecked(true);
 
+    connect(ui->actionFollowFile, &QAction::triggered, this, [=](bool b) {
+        currentEditor()->setFollowing(b);
+    });
+
     connect(ui->actionWordWrap, &QAction::triggered, this, [=](bool b) {
         if (b) {
             for (auto &editor : editors()) {
-                editor->setWrapMode(SC_WRAP_WORD);
+                if (!LargeFileProfile::isFeatureDisabled(editor, LargeFileProfile::WordWrap)) {
+                    editor->setWrapMode(SC_WRAP_WORD);
+                }
             }
         }
         else {
             for (auto &editor : editors()) {
                 // Store the top line and restore it after the lines have been unwrapped
-                int topLine = editor->docLineFromVisible(editor->firstVisibleLine());
+                Sci_Position topLine = editor->docLineFromVisible(editor->firstVisibleLine());
                 editor->setWrapMode(SC_WRAP_NONE);
                 editor->setFirstVisibleLine(topLine);
             }
@@ -702,6 +718,8 @@ MainWindow::MainWindow(NotepadNextApplication *app) :
     connect(app->getSettings(), &Settings::showToolBarChanged, ui->mainToolBar, &QToolBar::setVisible);
     connect(app->getSettings(), &Settings::showStatusBarChanged, ui->statusBar, &QStatusBar::setVisible);
 
+    connect(app->getFileChangeMonitor(), &FileChangeMonitor::changesDetected, this, &MainWindow::fileChangesDetected);
+
     setupLanguageMenu();
 
     // Put the style sheet here for now
@@ -1095,6 +1113,27 @@ bool MainWindow::saveFile(ScintillaNext *editor)
     }
 }
 
+void MainWindow::saveCurrentFileInBackground()
+{
+    saveFileInBackground(currentEditor());
+}
+
+void MainWindow::saveFileInBackground(ScintillaNext *editor)
+{
+    if (editor->isSavedToDisk())
+        return;
+
+    if (!editor->isFile()) {
+        // Switch to the editor and show the saveas dialog
+        dockedEditor->switchToEditor(editor);
+        saveCurrentFileAsDialog();
+    }
+    else {
+        // Any errors are reported once the write finishes
+        editor->saveInBackground();
+    }
+}
+
 bool MainWindow::saveCurrentFileAsDialog()
 {
     QString dialogDir;
@@ -1172,7 +1211,7 @@ bool MainWindow::saveCopyAs(const QString &fileName)
 void MainWindow::saveAll()
 {
     for (ScintillaNext *editor : editors()) {
-        saveFile(editor);
+        saveFileInBackground(editor);
     }
 }
 
@@ -1288,6 +1327,7 @@ void MainWindow::convertEOLs(int eolMode)
     // TODO: does convertEOLs trigger SCN_MODIFIED notifications? If so can these be turned off to increase performance?
     editor->convertEOLs(eolMode);
     editor->setEOLMode(eolMode);
+    editor->clearMixedEols();
 
     updateEOLBasedUi(editor);
 
@@ -1303,6 +1343,7 @@ void MainWindow::showFindReplaceDialog(int index)
 
     if (frd == Q_NULLPTR) {
         frd = new FindReplaceDialog(determineSearchResultsHandler(), this);
+        connect(findChild<SearchResultsDock *>(), &SearchResultsDock::cancelSearchRequested, frd, &FindReplaceDialog::cancelFindAllInDocuments);
     }
     else {
         frd->setSearchResultsHandler(determineSearchResultsHandler());
@@ -1314,20 +1355,20 @@ void MainWindow::showFindReplaceDialog(int index)
     // Get any selected text
     if (!editor->selectionEmpty()) {
         int selection = editor->mainSelection();
-        int start = editor->selectionNStart(selection);
-        int end = editor->selectionNEnd(selection);
+        Sci_Position start = editor->selectionNStart(selection);
+        Sci_Position end = editor->selectionNEnd(selection);
         if (end > start) {
-            auto selText = editor->get_text_range(start, end);
+            auto selText = editor->textRangeFull(start, end);
             frd->setFindString(QString::fromUtf8(selText));
         }
     }
     else {
-        int start = editor->wordStartPosition(editor->currentPos(), true);
-        int end = editor->wordEndPosition(editor->currentPos(), true);
+        Sci_Position start = editor->wordStartPosition(editor->currentPos(), true);
+        Sci_Position end = editor->wordEndPosition(editor->currentPos(), true);
         if (end > start) {
             editor->setSelectionStart(start);
             editor->setSelectionEnd(end);
-            auto selText = editor->get_text_range(start, end);
+            auto selText = editor->textRangeFull(start, end);
             frd->setFindString(QString::fromUtf8(selText));
         }
     }
@@ -1355,6 +1396,8 @@ void MainWindow::updateFileStatusBasedUi(ScintillaNext *editor)
     setWindowTitle(QStringLiteral("[*]%1").arg(fileName));
 
     ui->actionReload->setEnabled(isFile);
+    ui->actionFollowFile->setEnabled(isFile);
+    ui->actionFollowFile->setChecked(editor->isFollowing());
     ui->actionMoveToTrash->setEnabled(isFile);
     ui->actionCopyFullPath->setEnabled(isFile);
     ui->actionCopyFileDirectory->setEnabled(isFile);
@@ -1512,21 +1555,101 @@ void MainWindow::detectLanguage(ScintillaNext *editor)
     return;
 }
 
+void MainWindow::enableLargeFileFeature(ScintillaNext *editor, LargeFileProfile::Feature feature)
+{
+    qInfo(Q_FUNC_INFO);
+
+    LargeFileProfile *profile = LargeFileProfile::forEditor(editor);
+
+    if (profile == Q_NULLPTR) {
+        return;
+    }
+
+    const bool lexerFeature = feature == LargeFileProfile::SyntaxHighlighting || feature == LargeFileProfile::CodeFolding;
+
+    // Large files are loaded without styles, adding them moves the text into a new document which loses the undo history
+    if (lexerFeature && (editor->documentOptions() & SC_DOCUMENTOPTION_STYLES_NONE) && (editor->canUndo() || editor->canRedo()) && app->languageHasLexer(editor->languageName)) {
+        auto reply = QMessageBox::question(this, tr("Enable %1").arg(LargeFileProfile::featureName(feature)), tr("Enabling %1 for <b>%2</b> clears its undo history. Do you want to continue?").arg(LargeFileProfile::featureName(feature), editor->getName()));
+
+        if (reply != QMessageBox::Yes) {
+            return;
+        }
+    }
+
+    profile->enable(feature);
+
+    // The profile takes care of the decorators, the rest depends on the window
+    if (lexerFeature) {
+        // Folding comes from the lexer, so it needs highlighting as well
+        if (feature == LargeFileProfile::CodeFolding) {
+            profile->enable(LargeFileProfile::SyntaxHighlighting);
+        }
+
+        // Already confirmed above, so this skips setLanguage() and asking again
+        app->setEditorLanguage(editor, editor->languageName);
+    }
+    else if (feature == LargeFileProfile::WordWrap && ui->actionWordWrap->isChecked()) {
+        editor->setWrapMode(SC_WRAP_WORD);
+    }
+
+    if (editor == currentEditor()) {
+        ui->statusBar->refresh(editor);
+    }
+}
+
 void MainWindow::activateEditor(ScintillaNext *editor)
 {
     qInfo(Q_FUNC_INFO);
 
-    checkFileForModification(editor);
+    // Watched files are already kept up to date, so only hit the disk if it isn't being watched
+    if (!app->getFileChangeMonitor()->isWatching(editor)) {
+        checkFileForModification(editor);
+    }
+
     updateGui(editor);
 
     emit editorActivated(editor);
 }
 
+void MainWindow::fileChangesDetected(const QList<FileChangeMonitor::Change> &changes)
+{
+    qInfo(Q_FUNC_INFO);
+
+    const QVector<ScintillaNext *> windowEditors = editors();
+    bool updateNeeded = false;
+
+    for (const FileChangeMonitor::Change &change : changes) {
+        if (change.editor.isNull() || !windowEditors.contains(change.editor.data())) {
+            continue;
+        }
+
+        if (change.state == ScintillaNext::Modified) {
+            change.editor->reload();
+        }
+
+        updateNeeded = true;
+    }
+
+    if (updateNeeded && currentEditor()) {
+        updateGui(currentEditor());
+    }
+}
+
 void MainWindow::setLanguage(ScintillaNext *editor, const QString &languageName)
 {
     qInfo(Q_FUNC_INFO);
     qInfo("Language Name: %s", qUtf8Printable(languageName));
 
+    // Adding styles to a plain text document moves it into a new one, which loses the undo history
+    if (app->languageNeedsStyles(editor, languageName) && (editor->canUndo() || editor->canRedo())) {
+        auto reply = QMessageBox::question(this, tr("Change Language"), tr("Changing the language of <b>%1</b> clears its undo history. Do you want to continue?").arg(editor->getName()));
+
+        if (reply != QMessageBox::Yes) {
+            updateLanguageBasedUi(editor);
+            return;
+        }
+    }
+
     app->setEditorLanguage(editor, languageName);
 }
 
@@ -1685,8 +1808,10 @@ void MainWindow::focusIn()
 {
     qInfo(Q_FUNC_INFO);
 
-    if (checkFileForModification(currentEditor())) {
-        updateGui(currentEditor());
+    ScintillaNext *editor = currentEditor();
+
+    if (!app->getFileChangeMonitor()->isWatching(editor) && checkFileForModification(editor)) {
+        updateGui(editor);
     }
 }
 
@@ -1703,13 +1828,37 @@ void MainWindow::addEditor(ScintillaNext *editor)
     connect(editor, &ScintillaNext::renamed, this, [=]() { detectLanguage(editor); });
     connect(editor, &ScintillaNext::renamed, this, [=]() { updateFileStatusBasedUi(editor); });
     connect(editor, &ScintillaNext::updateUi, this, &MainWindow::updateDocumentBasedUi);
+    connect(editor, &ScintillaNext::saveFinished, this, [=](QFileDevice::FileError error) {
+        if (error != QFileDevice::NoError) {
+            showSaveErrorMessage(editor, error);
+        }
+    });
+    connect(editor, &ScintillaNext::loadFinished, this, [=](bool success) {
+        if (success) {
+            // The language detection above only had the file name to go on
+            detectLanguage(editor);
+
+            if (editor == currentEditor()) {
+                updateGui(editor);
+                ui->statusBar->refresh(editor);
+            }
+
+            if (editor->getFileAnalysis().isBinary) {
+                ui->statusBar->showMessage(tr("%1 contains NUL bytes and may be a binary file. Saving it could change its contents.").arg(editor->getName()), 10000);
+            }
+        }
+        else if (editorCount() == 0) {
+            // The failed editor has already been closed, so start with a new one
+            newFile();
+        }
+    });
 
     // Watch for any zoom events (Ctrl+Scroll or pinch-to-zoom (Qt translates it as Ctrl+Scroll)) so that the event
     // can be handled before the ScintillaEditBase widget, so that it can be applied to all editors to keep zoom level equal.
     // NOTE: Need to install this on the scroll area's viewport, not on the editor widget itself...that was painful to learn
     editor->viewport()->installEventFilter(zoomEventWatcher);
 
-    if (ui->actionWordWrap->isChecked())
+    if (ui->actionWordWrap->isChecked() && !LargeFileProfile::isFeatureDisabled(editor, LargeFileProfile::WordWrap))
         editor->setWrapMode(SC_WRAP_WHITESPACE);
 
     if (ui->actionShowIndentGuide->isChecked())
@@ -25,6 +25,8 @@
 #include <QActionGroup>
 
 #include "DockedEditor.h"
+#include "FileChangeMonitor.h"
+#include "LargeFileProfile.h"
 
 #include "MacroManager.h"
 #include "ScintillaNext.h"
@@ -77,6 +79,8 @@ public slots:
 
     bool saveCurrentFile();
     bool saveFile(ScintillaNext *editor);
+    void saveCurrentFileInBackground();
+    void saveFileInBackground(ScintillaNext *editor);
 
     bool saveCurrentFileAsDialog();
     bool saveCurrentFileAs(const QString &fileName);
@@ -113,6 +117,7 @@ public slots:
     void detectLanguage(ScintillaNext *editor);
 
     void setLanguage(ScintillaNext *editor, const QString &languageName);
+    void enableLargeFileFeature(ScintillaNext *editor, LargeFileProfile::Feature feature);
 
     void bringWindowToForeground();
     void focusIn();
@@ -139,6 +144,7 @@ private slots:
     void languageMenuTriggered();
     void checkForUpdatesFinished(QString url);
     void activateEditor(ScintillaNext *editor);
+    void fileChangesDetected(const QList<FileChangeMonitor::Change> &changes);
 
 private:
     Ui::MainWindow *ui = Q_NULLPTR;
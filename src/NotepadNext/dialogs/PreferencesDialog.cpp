@@ -49,6 +49,7 @@ PreferencesDialog::PreferencesDialog(Settings *settings, QWidget *parent) :
 
     ui->checkBoxUnsavedFiles->setChecked(settings->restoreUnsavedFiles());
     ui->checkBoxRestoreTempFiles->setChecked(settings->restoreTempFiles());
+    ui->checkBoxPrefetchSessionFiles->setChecked(settings->prefetchSessionFiles());
 
     connect(ui->gbxRestorePreviousSession, &QGroupBox::toggled, ui->checkBoxRestoreTempFiles, &QCheckBox::setEnabled);
 
@@ -68,9 +69,25 @@ PreferencesDialog::PreferencesDialog(Settings *settings, QWidget *parent) :
     connect(settings, &Settings::restoreTempFilesChanged, ui->checkBoxRestoreTempFiles, &QCheckBox::setChecked);
     connect(ui->checkBoxRestoreTempFiles, &QCheckBox::toggled, settings, &Settings::setRestoreTempFiles);
 
+    connect(settings, &Settings::prefetchSessionFilesChanged, ui->checkBoxPrefetchSessionFiles, &QCheckBox::setChecked);
+    connect(ui->checkBoxPrefetchSessionFiles, &QCheckBox::toggled, settings, &Settings::setPrefetchSessionFiles);
+
     ui->checkBoxCombineSearchResults->setChecked(settings->combineSearchResults());
     connect(settings, &Settings::combineSearchResultsChanged, ui->checkBoxCombineSearchResults, &QCheckBox::setChecked);
     connect(ui->checkBoxCombineSearchResults, &QCheckBox::toggled, settings, &Settings::setCombineSearchResults);
+
+    // Only affects files opened after the change
+    ui->spinBoxLargeFileSize->setValue(settings->largeFileSize());
+    connect(settings, &Settings::largeFileSizeChanged, ui->spinBoxLargeFileSize, &QSpinBox::setValue);
+    connect(ui->spinBoxLargeFileSize, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged), settings, &Settings::setLargeFileSize);
+
+    ui->spinBoxLargeFileLineLength->setValue(settings->largeFileLineLength());
+    connect(settings, &Settings::largeFileLineLengthChanged, ui->spinBoxLargeFileLineLength, &QSpinBox::setValue);
+    connect(ui->spinBoxLargeFileLineLength, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged), settings, &Settings::setLargeFileLineLength);
+
+    ui->spinBoxPagedFileSize->setValue(settings->pagedFileSize());
+    connect(settings, &Settings::pagedFileSizeChanged, ui->spinBoxPagedFileSize, &QSpinBox::setValue);
+    connect(ui->spinBoxPagedFileSize, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged), settings, &Settings::setPagedFileSize);
 }
 
 PreferencesDialog::~PreferencesDialog()
@@ -48,6 +48,10 @@ SearchResultsDock::SearchResultsDock(QWidget *parent) :
     // Close the results when escape is pressed
     new QShortcut(QKeySequence::Cancel, this, this, &SearchResultsDock::close, Qt::WidgetWithChildrenShortcut);
 
+    // Only shown while results are still coming in
+    ui->buttonCancelSearch->hide();
+    connect(ui->buttonCancelSearch, &QPushButton::clicked, this, &SearchResultsDock::cancelSearchRequested);
+
     connect(ui->treeWidget, &QTreeWidget::itemActivated, this, &SearchResultsDock::itemActivated);
     connect(ui->treeWidget, &QTreeWidget::itemExpanded, this, &SearchResultsDock::itemExpanded);
 
@@ -94,6 +98,8 @@ void SearchResultsDock::newSearch(const QString searchTerm)
     currentSearch->setExpanded(true);
     currentSearch->setFirstColumnSpanned(true);
 
+    ui->buttonCancelSearch->show();
+
     updateSearchStatus();
 }
 
@@ -117,15 +123,15 @@ void SearchResultsDock::newFileEntry(ScintillaNext *editor)
     updateSearchStatus();
 }
 
-void SearchResultsDock::newResultsEntry(const QString line, int lineNumber, int startPositionFromBeginning, int endPositionFromBeginning, int hitCount)
+void SearchResultsDock::newResultsEntry(const QString line, Sci_Position lineNumber, Sci_Position startPositionFromBeginning, Sci_Position endPositionFromBeginning, int hitCount)
 {
     QTreeWidgetItem *item = new QTreeWidgetItem(currentFile);
 
     // Scintilla internally references line numbers starting at 0, however it needs displayed starting at 1
     item->setText(0, QString::number(lineNumber + 1));
-    item->setData(0, SearchResultData::LineNumber, lineNumber);
-    item->setData(0, SearchResultData::LinePosStart, startPositionFromBeginning);
-    item->setData(0, SearchResultData::LinePosEnd, endPositionFromBeginning);
+    item->setData(0, SearchResultData::LineNumber, static_cast<qlonglong>(lineNumber));
+    item->setData(0, SearchResultData::LinePosStart, static_cast<qlonglong>(startPositionFromBeginning));
+    item->setData(0, SearchResultData::LinePosEnd, static_cast<qlonglong>(endPositionFromBeginning));
     item->setBackground(0, QBrush(QColor(220, 220, 220)));
     item->setTextAlignment(0, Qt::AlignRight);
 
@@ -145,6 +151,8 @@ void SearchResultsDock::completeSearch()
     totalFileHitCount = 0;
     totalHitCount = 0;
 
+    ui->buttonCancelSearch->hide();
+
     ui->treeWidget->resizeColumnToContents(0);
     ui->treeWidget->resizeColumnToContents(1);
 }
@@ -161,6 +169,8 @@ void SearchResultsDock::expandAll() const
 
 void SearchResultsDock::deleteEntry(QTreeWidgetItem *item)
 {
+    cancelSearchIfRemoving(item);
+
     QTreeWidgetItem *parent = item->parent();
 
     if (parent != Q_NULLPTR) {
@@ -175,6 +185,8 @@ void SearchResultsDock::deleteEntry(QTreeWidgetItem *item)
 
 void SearchResultsDock::deleteAll()
 {
+    cancelSearchIfRemoving(currentSearch);
+
     ui->treeWidget->clear();
 }
 
@@ -189,9 +201,9 @@ void SearchResultsDock::itemActivated(QTreeWidgetItem *item, int column)
 
         // The editor may no longer exist
         if (editor) {
-            int lineNumber = item->data(0, SearchResultData::LineNumber).toInt();
-            int startPositionFromBeginning = item->data(0, SearchResultData::LinePosStart).toInt();
-            int endPositionFromBeginning = item->data(0, SearchResultData::LinePosEnd).toInt();
+            Sci_Position lineNumber = item->data(0, SearchResultData::LineNumber).toLongLong();
+            Sci_Position startPositionFromBeginning = item->data(0, SearchResultData::LinePosStart).toLongLong();
+            Sci_Position endPositionFromBeginning = item->data(0, SearchResultData::LinePosEnd).toLongLong();
 
             emit searchResultActivated(editor, lineNumber, startPositionFromBeginning, endPositionFromBeginning);
         }
@@ -210,3 +222,11 @@ void SearchResultsDock::updateSearchStatus()
     if (currentFile)
         currentFile->setText(0, QStringLiteral("%1 (%L2 hits)").arg(currentFilePath).arg(totalFileHitCount));
 }
+
+void SearchResultsDock::cancelSearchIfRemoving(QTreeWidgetItem *item)
+{
+    // A search that is still running keeps adding to its items, so it has to stop before they are deleted
+    if (item != Q_NULLPTR && (item == currentSearch || item == currentFile)) {
+        emit cancelSearchRequested();
+    }
+}
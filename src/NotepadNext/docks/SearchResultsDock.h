@@ -41,7 +41,7 @@ public:
 
     void newSearch(const QString searchTerm) override;
     void newFileEntry(ScintillaNext *editor) override;
-    void newResultsEntry(const QString line, int lineNumber, int startPositionFromBeginning, int endPositionFromBeginning, int hitCount=1) override;
+    void newResultsEntry(const QString line, Sci_Position lineNumber, Sci_Position startPositionFromBeginning, Sci_Position endPositionFromBeginning, int hitCount=1) override;
     void completeSearch() override;
 
 public slots:
@@ -55,10 +55,12 @@ private slots:
     void itemExpanded(QTreeWidgetItem *item);
 
 signals:
-    void searchResultActivated(ScintillaNext *editor, int lineNumber, int startPositionFromBeginning, int endPositionFromBeginning);
+    void searchResultActivated(ScintillaNext *editor, Sci_Position lineNumber, Sci_Position startPositionFromBeginning, Sci_Position endPositionFromBeginning);
+    void cancelSearchRequested();
 
 private:
     void updateSearchStatus();
+    void cancelSearchIfRemoving(QTreeWidgetItem *item);
     Ui::SearchResultsDock *ui;
 
     QString searchTerm;
@@ -18,12 +18,17 @@
 
 
 #include "EditorInfoStatusBar.h"
+#include "LargeFileProfile.h"
 #include "MainWindow.h"
+#include "PagedFileView.h"
 #include "StatusLabel.h"
 
+#include <QMenu>
+
 
 EditorInfoStatusBar::EditorInfoStatusBar(QMainWindow *window) :
-    QStatusBar(window)
+    QStatusBar(window),
+    window(qobject_cast<MainWindow *>(window))
 {
     // Set up the status bar
     docType = new StatusLabel();
@@ -41,6 +46,14 @@ EditorInfoStatusBar::EditorInfoStatusBar(QMainWindow *window) :
     unicodeType = new StatusLabel(125);
     addPermanentWidget(unicodeType, 0);
 
+    // Only shown when the large file profile is in use
+    largeFile = new StatusLabel(80);
+    largeFile->setText(tr("Large File"));
+    largeFile->setToolTip(tr("Some features are turned off for this file. Click to turn them back on."));
+    largeFile->hide();
+    addPermanentWidget(largeFile, 0);
+    connect(largeFile, &StatusLabel::clicked, this, &EditorInfoStatusBar::showLargeFileMenu);
+
     /*
     docType->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(docType, &QLabel::customContextMenuRequested, [=](const QPoint &pos) {
@@ -53,9 +66,7 @@ EditorInfoStatusBar::EditorInfoStatusBar(QMainWindow *window) :
     });
     */
 
-    MainWindow *w = qobject_cast<MainWindow *>(window);
-
-    connect(w, &MainWindow::editorActivated, this, &EditorInfoStatusBar::connectToEditor);
+    connect(this->window, &MainWindow::editorActivated, this, &EditorInfoStatusBar::connectToEditor);
 }
 
 void EditorInfoStatusBar::refresh(ScintillaNext *editor)
@@ -65,6 +76,7 @@ void EditorInfoStatusBar::refresh(ScintillaNext *editor)
     updateLanguage(editor);
     updateEol(editor);
     updateEncoding(editor);
+    updateLargeFile(editor);
 }
 
 void EditorInfoStatusBar::connectToEditor(ScintillaNext *editor)
@@ -72,10 +84,12 @@ void EditorInfoStatusBar::connectToEditor(ScintillaNext *editor)
     // Remove any previous connections
     disconnect(editorUiUpdated);
     disconnect(documentLexerChanged);
+    disconnect(documentEncodingChanged);
 
     // Connect to the new editor
     editorUiUpdated = connect(editor, &ScintillaNext::updateUi, this, &EditorInfoStatusBar::editorUpdated);
     documentLexerChanged = connect(editor, &ScintillaNext::lexerChanged, this, [=]() { updateLanguage(editor); });
+    documentEncodingChanged = connect(editor, &ScintillaNext::encodingChanged, this, [=]() { updateEncoding(editor); });
 
     refresh(editor);
 }
@@ -95,7 +109,12 @@ void EditorInfoStatusBar::editorUpdated(Scintilla::Update updated)
 
 void EditorInfoStatusBar::updateDocumentSize(ScintillaNext *editor)
 {
-    QString sizeText = tr("Length: %L1    Lines: %L2").arg(editor->length()).arg(editor->lineCount());
+    // Paged editors only hold part of the file
+    const PagedFileView *view = PagedFileView::forEditor(editor);
+    const qint64 length = view ? view->fileSize() : editor->length();
+    const qint64 lines = view ? view->lineCount() : editor->lineCount();
+
+    QString sizeText = tr("Length: %L1    Lines: %L2").arg(length).arg(lines);
     docSize->setText(sizeText);
 }
 
@@ -107,9 +126,9 @@ void EditorInfoStatusBar::updateSelectionInfo(ScintillaNext *editor)
         selectionText = tr("Sel: N/A");
     }
     else {
-        int start = editor->selectionStart();
-        int end = editor->selectionEnd();
-        int lines = editor->lineFromPosition(end) - editor->lineFromPosition(start);
+        Sci_Position start = editor->selectionStart();
+        Sci_Position end = editor->selectionEnd();
+        Sci_Position lines = editor->lineFromPosition(end) - editor->lineFromPosition(start);
 
         if (end > start)
             lines++;
@@ -117,8 +136,10 @@ void EditorInfoStatusBar::updateSelectionInfo(ScintillaNext *editor)
         selectionText = tr("Sel: %L1 | %L2").arg(editor->countCharacters(start, end)).arg(lines);
     }
 
-    const int pos = editor->currentPos();
-    QString positionText = tr("Ln: %L1    Col: %L2    ").arg(editor->lineFromPosition(pos) + 1).arg(editor->column(pos) + 1);
+    const Sci_Position pos = editor->currentPos();
+    const PagedFileView *view = PagedFileView::forEditor(editor);
+    const qint64 line = view ? view->currentLine() : editor->lineFromPosition(pos);
+    QString positionText = tr("Ln: %L1    Col: %L2    ").arg(line + 1).arg(editor->column(pos) + 1);
     docPos->setText(positionText + selectionText);
 }
 
@@ -143,10 +164,31 @@ void EditorInfoStatusBar::updateEol(ScintillaNext *editor)
         eolFormat->setText(tr("Unix (LF)"));
         break;
     }
+
+    // The mode only says what new lines get, the file itself may have a mix of them
+    if (editor->getFileAnalysis().hasMixedEols) {
+        eolFormat->setText(eolFormat->text() + tr(" (Mixed)"));
+        eolFormat->setToolTip(tr("The file has more than one kind of line ending. Use EOL Conversion to make them the same."));
+    }
+    else {
+        eolFormat->setToolTip(QString());
+    }
 }
 
 void EditorInfoStatusBar::updateEncoding(ScintillaNext *editor)
 {
+    // Show what the file will be saved as rather than how it is stored internally
+    const FileEncoding encoding = editor->getEncoding();
+
+    if (!encoding.isUtf8()) {
+        unicodeType->setText(QString::fromLatin1(encoding.codecName) + (encoding.hasBom ? tr(" BOM") : QString()));
+        return;
+    }
+    else if (encoding.hasBom) {
+        unicodeType->setText(tr("UTF-8 BOM"));
+        return;
+    }
+
     switch(editor->codePage()) {
     case 0:
         unicodeType->setText(tr("ANSI"));
@@ -160,3 +202,35 @@ void EditorInfoStatusBar::updateEncoding(ScintillaNext *editor)
     }
 }
 
+
+void EditorInfoStatusBar::updateLargeFile(ScintillaNext *editor)
+{
+    const LargeFileProfile *profile = LargeFileProfile::forEditor(editor);
+
+    largeFile->setVisible(profile != Q_NULLPTR && !profile->disabledFeatures().isEmpty());
+}
+
+void EditorInfoStatusBar::showLargeFileMenu()
+{
+    QPointer<ScintillaNext> editor = window->currentEditor();
+    const LargeFileProfile *profile = LargeFileProfile::forEditor(editor);
+
+    if (profile == Q_NULLPTR) {
+        return;
+    }
+
+    QMenu *menu = new QMenu(this);
+    menu->setAttribute(Qt::WA_DeleteOnClose);
+
+    for (LargeFileProfile::Feature feature : profile->disabledFeatures()) {
+        QAction *action = menu->addAction(tr("Enable %1").arg(LargeFileProfile::featureName(feature)));
+
+        connect(action, &QAction::triggered, window, [=]() {
+            if (editor) {
+                window->enableLargeFileFeature(editor, feature);
+            }
+        });
+    }
+
+    menu->popup(largeFile->mapToGlobal(QPoint(0, 0)));
+}
@@ -27,7 +27,9 @@
 
 class QLabel;
 class QMainWindow;
+class MainWindow;
 class ScintillaNext;
+class StatusLabel;
 
 class EditorInfoStatusBar : public QStatusBar
 {
@@ -48,16 +50,23 @@ private slots:
     void updateLanguage(ScintillaNext *editor);
     void updateEol(ScintillaNext *editor);
     void updateEncoding(ScintillaNext *editor);
+    void updateLargeFile(ScintillaNext *editor);
+
+    void showLargeFileMenu();
 
 private:
+    MainWindow *window;
+
     QLabel *docType;
     QLabel *docSize;
     QLabel *docPos;
     QLabel *unicodeType;
     QLabel *eolFormat;
+    StatusLabel *largeFile;
 
     QMetaObject::Connection editorUiUpdated;
     QMetaObject::Connection documentLexerChanged;
+    QMetaObject::Connection documentEncodingChanged;
 };
 
 #endif // EDITORINFOSTATUSBAR_H
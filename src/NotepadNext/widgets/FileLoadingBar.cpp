@@ -0,0 +1,70 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2024 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "FileLoadingBar.h"
+
+#include <QEvent>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QProgressBar>
+#include <QPushButton>
+
+
+FileLoadingBar::FileLoadingBar(QWidget *parent) :
+    QFrame(parent),
+    progressBar(new QProgressBar())
+{
+    setFrameShape(QFrame::StyledPanel);
+    setAutoFillBackground(true);
+
+    progressBar->setRange(0, 100);
+    progressBar->setValue(0);
+
+    QPushButton *cancelButton = new QPushButton(tr("Cancel"));
+    connect(cancelButton, &QPushButton::clicked, this, &FileLoadingBar::cancelRequested);
+
+    QHBoxLayout *layout = new QHBoxLayout(this);
+    layout->setContentsMargins(6, 3, 6, 3);
+    layout->addWidget(new QLabel(tr("Loading...")));
+    layout->addWidget(progressBar, 1);
+    layout->addWidget(cancelButton);
+
+    // Keep it stretched across the top of the editor
+    parent->installEventFilter(this);
+    updateGeometryFromParent();
+}
+
+void FileLoadingBar::setProgress(int percent)
+{
+    progressBar->setValue(percent);
+}
+
+bool FileLoadingBar::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == parent() && event->type() == QEvent::Resize) {
+        updateGeometryFromParent();
+    }
+
+    return QFrame::eventFilter(watched, event);
+}
+
+void FileLoadingBar::updateGeometryFromParent()
+{
+    setGeometry(0, 0, parentWidget()->width(), sizeHint().height());
+}
@@ -0,0 +1,29 @@
+# This file is part of Notepad Next.
+# Copyright 2024 Justin Dailey
+#
+# Notepad Next is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Notepad Next is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+
+
+# Only the 8 bit library is needed since Scintilla stores documents as UTF-8
+DEFINES += PCRE2_CODE_UNIT_WIDTH=8
+
+# Needs at least 10.34 for PCRE2_MATCH_INVALID_UTF. Set PCRE2_DIR if pkg-config is not available
+isEmpty(PCRE2_DIR) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += libpcre2-8
+}
+else {
+    INCLUDEPATH += $$PCRE2_DIR/include
+    LIBS += -L$$PCRE2_DIR/lib -lpcre2-8
+}